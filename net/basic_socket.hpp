@@ -0,0 +1,404 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_BASIC_SOCKET_HPP
+#define LIBNET_BASIC_SOCKET_HPP
+
+#include <net/socket.hpp>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#if !defined(LIBNET_WINDOWS)
+#include <sys/un.h>
+#endif // LIBNET_WINDOWS
+
+namespace net {
+namespace detail {
+template<int Family>
+struct family_traits;
+
+template<>
+struct family_traits<AF_INET> {
+    using address_type = sockaddr_in;
+    static constexpr bool is_inet = true;
+};
+
+template<>
+struct family_traits<AF_INET6> {
+    using address_type = sockaddr_in6;
+    static constexpr bool is_inet = true;
+};
+
+#if !defined(LIBNET_WINDOWS)
+template<>
+struct family_traits<AF_UNIX> {
+    using address_type = sockaddr_un;
+    static constexpr bool is_inet = false;
+};
+#endif // LIBNET_WINDOWS
+} // detail
+
+// A socket whose family and type are fixed at compile time. compared to
+// net::socket this never has to ask the kernel for its type, only offers
+// the operations that make sense for it (e.g. no listen on datagram sockets)
+// and passes the exact address size to the kernel. as_socket() gives the
+// type-erased net::socket for code that doesn't care.
+template<int Family, int Type>
+struct basic_socket : private socket {
+public:
+    using native_type = socket::native_type;
+    using address_type = typename detail::family_traits<Family>::address_type;
+
+    static constexpr int family() noexcept {
+        return Family;
+    }
+
+    static constexpr int type() noexcept {
+        return Type;
+    }
+
+    basic_socket(): socket(Family, Type) {}
+
+    const socket& as_socket() const noexcept {
+        return *this;
+    }
+
+    using socket::close;
+    using socket::native_handle;
+    using socket::shutdown;
+    using socket::non_blocking;
+    using socket::reuse_port;
+    using socket::send;
+    using socket::receive;
+#if defined(LIBNET_LINUX)
+    using socket::attach_filter;
+    using socket::detach_filter;
+    using socket::attach_reuseport;
+    using socket::timestamp;
+    using socket::receive_timestamped;
+    using socket::receive_tx_timestamp;
+#endif // LIBNET_LINUX
+
+    // inet families
+
+    template<typename String>
+    void connect(const String& host, unsigned port, std::error_code& ec) const noexcept {
+        static_assert(detail::family_traits<Family>::is_inet, "host and port are only meaningful for IPv4 and IPv6");
+        connector(detail::string_traits<String>::c_str(host), port, Type, ec);
+    }
+
+    template<typename String>
+    void connect(const String& host, unsigned port) const {
+        std::error_code ec;
+        connect(host, port, ec);
+        error::throw_on(ec, "basic_socket::connect");
+    }
+
+    template<typename String>
+    void bind(const String& host, unsigned port, std::error_code& ec) const noexcept {
+        static_assert(detail::family_traits<Family>::is_inet, "host and port are only meaningful for IPv4 and IPv6");
+        binder(detail::string_traits<String>::c_str(host), port, Type, ec);
+    }
+
+    void bind(unsigned port, std::error_code& ec) const noexcept {
+        static_assert(detail::family_traits<Family>::is_inet, "port is only meaningful for IPv4 and IPv6");
+        binder(nullptr, port, Type, ec);
+    }
+
+    template<typename String>
+    void bind(const String& host, unsigned port) const {
+        std::error_code ec;
+        bind(host, port, ec);
+        error::throw_on(ec, "basic_socket::bind");
+    }
+
+    void bind(unsigned port) const {
+        std::error_code ec;
+        bind(port, ec);
+        error::throw_on(ec, "basic_socket::bind");
+    }
+
+    // all families
+
+    void connect(const endpoint& peer, std::error_code& ec) const noexcept {
+        ec.clear();
+        if(!matches(peer, ec)) {
+            return;
+        }
+
+        int ret = ::connect(fd, peer.data(), address_size(peer));
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    void connect(const endpoint& peer) const {
+        std::error_code ec;
+        connect(peer, ec);
+        error::throw_on(ec, "basic_socket::connect");
+    }
+
+    void bind(const endpoint& local, std::error_code& ec) const noexcept {
+        ec.clear();
+        if(!matches(local, ec)) {
+            return;
+        }
+
+        int ret = ::bind(fd, local.data(), address_size(local));
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    void bind(const endpoint& local) const {
+        std::error_code ec;
+        bind(local, ec);
+        error::throw_on(ec, "basic_socket::bind");
+    }
+
+#if !defined(LIBNET_WINDOWS)
+    // unix domain, a path beginning with a null character is an abstract address
+
+    template<typename String, int F = Family, typename = typename std::enable_if<F == AF_UNIX>::type>
+    void connect(const String& path, std::error_code& ec) const noexcept {
+        ec.clear();
+        sockaddr_un address;
+        auto size = unix_address(detail::string_traits<String>::c_str(path), detail::string_traits<String>::size(path), address, ec);
+        if(ec) {
+            return;
+        }
+
+        int ret = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), size);
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    template<typename String, int F = Family, typename = typename std::enable_if<F == AF_UNIX>::type>
+    void connect(const String& path) const {
+        std::error_code ec;
+        connect(path, ec);
+        error::throw_on(ec, "basic_socket::connect");
+    }
+
+    template<typename String, int F = Family, typename = typename std::enable_if<F == AF_UNIX>::type>
+    void bind(const String& path, std::error_code& ec) const noexcept {
+        ec.clear();
+        sockaddr_un address;
+        auto size = unix_address(detail::string_traits<String>::c_str(path), detail::string_traits<String>::size(path), address, ec);
+        if(ec) {
+            return;
+        }
+
+        int ret = ::bind(fd, reinterpret_cast<const sockaddr*>(&address), size);
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    template<typename String, int F = Family, typename = typename std::enable_if<F == AF_UNIX>::type>
+    void bind(const String& path) const {
+        std::error_code ec;
+        bind(path, ec);
+        error::throw_on(ec, "basic_socket::bind");
+    }
+#endif // LIBNET_WINDOWS
+
+    // stream sockets
+
+    void listen(int backlog, std::error_code& ec) const noexcept {
+        static_assert(Type == SOCK_STREAM, "listen is only available on stream sockets");
+        socket::listen(backlog, ec);
+    }
+
+    void listen(int backlog = 10) const {
+        std::error_code ec;
+        listen(backlog, ec);
+        error::throw_on(ec, "basic_socket::listen");
+    }
+
+    basic_socket accept(endpoint& peer, std::error_code& ec) const noexcept {
+        static_assert(Type == SOCK_STREAM, "accept is only available on stream sockets");
+        ec.clear();
+        auto size = endpoint::capacity();
+
+        native_type ret = ::accept(fd, peer.data(), &size);
+        if(ret == socket::invalid) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return basic_socket(socket::invalid, detail::adopt_t{});
+        }
+
+        peer.resize(size);
+        return basic_socket(ret, detail::adopt_t{});
+    }
+
+    basic_socket accept(endpoint& peer) const {
+        std::error_code ec;
+        auto&& ret = accept(peer, ec);
+        error::throw_on(ec, "basic_socket::accept");
+        return std::move(ret);
+    }
+
+    basic_socket accept(std::error_code& ec) const noexcept {
+        endpoint peer;
+        return accept(peer, ec);
+    }
+
+    basic_socket accept() const {
+        std::error_code ec;
+        auto&& ret = accept(ec);
+        error::throw_on(ec, "basic_socket::accept");
+        return std::move(ret);
+    }
+
+    template<typename String, typename Data>
+    int fast_connect(const String& host, unsigned port, const Data& data, int flags, std::error_code& ec) const noexcept {
+        static_assert(Type == SOCK_STREAM && detail::family_traits<Family>::is_inet, "fast open is only available on TCP sockets");
+        return fast_connector(detail::string_traits<String>::c_str(host), port, data, flags, Type, ec);
+    }
+
+    template<typename String, typename Data>
+    int fast_connect(const String& host, unsigned port, const Data& data, int flags = 0) const {
+        std::error_code ec;
+        int result = fast_connect(host, port, data, flags, ec);
+        error::throw_on(ec, "basic_socket::fast_connect");
+        return result;
+    }
+
+    template<typename... Args>
+    void fast_open(Args&&... args) const {
+        static_assert(Type == SOCK_STREAM && detail::family_traits<Family>::is_inet, "fast open is only available on TCP sockets");
+        socket::fast_open(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void fast_open_connect(Args&&... args) const {
+        static_assert(Type == SOCK_STREAM && detail::family_traits<Family>::is_inet, "fast open is only available on TCP sockets");
+        socket::fast_open_connect(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void defer_accept(Args&&... args) const {
+        static_assert(Type == SOCK_STREAM && detail::family_traits<Family>::is_inet, "deferred accept is only available on TCP sockets");
+        socket::defer_accept(std::forward<Args>(args)...);
+    }
+
+    // datagram sockets
+
+    template<typename String>
+    int send_to(const String& str, const endpoint& peer, int flags, std::error_code& ec) const noexcept {
+        static_assert(Type == SOCK_DGRAM, "send_to is only available on datagram sockets");
+        ec.clear();
+        if(!matches(peer, ec)) {
+            return 0;
+        }
+
+        using trait_type = detail::string_traits<String>;
+        int ret = ::sendto(fd, trait_type::c_str(str), trait_type::size(str), flags, peer.data(), address_size(peer));
+        if(ret < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return 0;
+        }
+    #if defined(LIBNET_CAPTURE)
+        detail::tap(fd, true, trait_type::c_str(str), static_cast<size_t>(ret), &peer);
+    #endif // LIBNET_CAPTURE
+        return ret;
+    }
+
+    template<typename String>
+    int send_to(const String& str, const endpoint& peer, int flags = 0) const {
+        std::error_code ec;
+        int result = send_to(str, peer, flags, ec);
+        error::throw_on(ec, "basic_socket::send_to");
+        return result;
+    }
+
+    template<typename... Args>
+    std::string receive_from(Args&&... args) const {
+        static_assert(Type == SOCK_DGRAM, "receive_from is only available on datagram sockets");
+        return socket::receive_from(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    bool segmentation_offload(Args&&... args) const {
+        static_assert(Type == SOCK_DGRAM && detail::family_traits<Family>::is_inet, "segmentation offload is only available on UDP sockets");
+        return socket::segmentation_offload(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    int send_segmented(Args&&... args) const {
+        static_assert(Type == SOCK_DGRAM && detail::family_traits<Family>::is_inet, "segmentation offload is only available on UDP sockets");
+        return socket::send_segmented(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void coalesce(Args&&... args) const {
+        static_assert(Type == SOCK_DGRAM && detail::family_traits<Family>::is_inet, "coalescing is only available on UDP sockets");
+        socket::coalesce(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    std::string receive_coalesced(Args&&... args) const {
+        static_assert(Type == SOCK_DGRAM && detail::family_traits<Family>::is_inet, "coalescing is only available on UDP sockets");
+        return socket::receive_coalesced(std::forward<Args>(args)...);
+    }
+private:
+    basic_socket(native_type new_fd, detail::adopt_t tag): socket(new_fd, Family, tag) {}
+
+    bool matches(const endpoint& address, std::error_code& ec) const noexcept {
+        if(address.family() != Family) {
+            ec = error::address_family_not_supported;
+            return false;
+        }
+        return true;
+    }
+
+    // inet addresses have a fixed size, unix addresses depend on the path
+    static endpoint::length_type address_size(const endpoint& address) noexcept {
+        return detail::family_traits<Family>::is_inet ? static_cast<endpoint::length_type>(sizeof(address_type)) : address.size();
+    }
+
+#if !defined(LIBNET_WINDOWS)
+    static socklen_t unix_address(const char* path, size_t size, sockaddr_un& address, std::error_code& ec) noexcept {
+        address = sockaddr_un();
+        address.sun_family = AF_UNIX;
+        if(size >= sizeof(address.sun_path)) {
+            ec = error::name_too_long;
+            return 0;
+        }
+
+        std::memcpy(address.sun_path, path, size);
+        return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + size + (size > 0 && path[0] != '\0' ? 1 : 0));
+    }
+#endif // LIBNET_WINDOWS
+};
+
+using tcp4 = basic_socket<socket::ipv4, socket::stream>;
+using tcp6 = basic_socket<socket::ipv6, socket::stream>;
+using udp4 = basic_socket<socket::ipv4, socket::datagram>;
+using udp6 = basic_socket<socket::ipv6, socket::datagram>;
+#if !defined(LIBNET_WINDOWS)
+using unix_stream = basic_socket<AF_UNIX, socket::stream>;
+using unix_datagram = basic_socket<AF_UNIX, socket::datagram>;
+#endif // LIBNET_WINDOWS
+} // net
+
+#endif // LIBNET_BASIC_SOCKET_HPP
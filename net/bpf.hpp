@@ -0,0 +1,159 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_BPF_HPP
+#define LIBNET_BPF_HPP
+
+// A small builder for classic BPF programs, used for socket filters
+// (socket::attach_filter) and SO_REUSEPORT group steering
+// (socket::attach_reuseport). Linux only.
+
+#include <net/detail/config.hpp>
+
+#if defined(LIBNET_LINUX)
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <linux/filter.h>
+
+#if !defined(BPF_MOD)
+#define BPF_MOD 0x90
+#endif // BPF_MOD
+
+namespace net {
+namespace bpf {
+enum : uint16_t {
+    byte = BPF_B,
+    half = BPF_H,
+    word = BPF_W
+};
+
+// data the kernel exposes through loads at SKF_AD_OFF
+enum : int32_t {
+    protocol = SKF_AD_PROTOCOL,
+    queue    = SKF_AD_QUEUE,
+    rxhash   = SKF_AD_RXHASH,
+    cpu      = SKF_AD_CPU,
+    random   = SKF_AD_RANDOM
+};
+
+struct program {
+public:
+    // A = packet[offset], offset is relative to the start of the data the filter
+    // sees. for UDP reuseport programs this is the payload, the UDP header is skipped.
+    program& load(uint16_t size, uint32_t offset) {
+        return add(BPF_STMT(BPF_LD | size | BPF_ABS, offset));
+    }
+
+    // A = one of the ancillary values (bpf::cpu, bpf::rxhash, ...)
+    program& load_ancillary(int32_t what) {
+        return add(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + what)));
+    }
+
+    // A = length of the data the filter sees
+    program& load_length() {
+        return add(BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0));
+    }
+
+    // A = value
+    program& load_immediate(uint32_t value) {
+        return add(BPF_STMT(BPF_LD | BPF_IMM, value));
+    }
+
+    // A = A <op> value where op is one of BPF_ADD, BPF_AND, BPF_MOD, ...
+    program& alu(uint16_t op, uint32_t value) {
+        return add(BPF_STMT(BPF_ALU | op | BPF_K, value));
+    }
+
+    // if A <op> value, skip if_true instructions otherwise skip if_false instructions.
+    // op is one of BPF_JEQ, BPF_JGT, BPF_JGE or BPF_JSET.
+    program& jump(uint16_t op, uint32_t value, uint8_t if_true, uint8_t if_false) {
+        return add(BPF_JUMP(BPF_JMP | op | BPF_K, value, if_true, if_false));
+    }
+
+    // for filters this is the number of bytes to accept (0 drops the packet),
+    // for reuseport programs it's the index of the socket in the group.
+    program& ret(uint32_t value) {
+        return add(BPF_STMT(BPF_RET | BPF_K, value));
+    }
+
+    program& ret_accumulator() {
+        return add(BPF_STMT(BPF_RET | BPF_A, 0));
+    }
+
+    size_t size() const noexcept {
+        return code.size();
+    }
+
+    bool empty() const noexcept {
+        return code.empty();
+    }
+
+    // the kernel rejects programs longer than this
+    static constexpr size_t max_size() noexcept {
+        return BPF_MAXINSNS;
+    }
+
+    sock_fprog native() const noexcept {
+        sock_fprog result;
+        result.len = static_cast<unsigned short>(code.size());
+        result.filter = const_cast<sock_filter*>(code.data());
+        return result;
+    }
+private:
+    program& add(sock_filter instruction) {
+        code.push_back(instruction);
+        return *this;
+    }
+
+    std::vector<sock_filter> code;
+};
+
+// steers each packet to the socket at index cpu % group_size, so with one
+// listener per CPU added in CPU order a flow stays on the core that received it.
+inline program cpu_affinity(uint32_t group_size) {
+    program result;
+    result.load_ancillary(bpf::cpu)
+          .alu(BPF_MOD, group_size)
+          .ret_accumulator();
+    return result;
+}
+
+// steers UDP packets by a big endian field in the payload, e.g. a connection
+// or session id, to the socket at index field % group_size. packets too short
+// to contain the field get an out of range index which makes the kernel fall
+// back to its default hash.
+inline program udp_field(uint16_t size, uint32_t offset, uint32_t group_size) {
+    uint32_t width = size == bpf::byte ? 1 : (size == bpf::half ? 2 : 4);
+    program result;
+    result.load_length()
+          .jump(BPF_JGE, offset + width, 1, 0)
+          .ret(0xFFFFFFFF)
+          .load(size, offset)
+          .alu(BPF_MOD, group_size)
+          .ret_accumulator();
+    return result;
+}
+} // bpf
+} // net
+
+#endif // LIBNET_LINUX
+#endif // LIBNET_BPF_HPP
@@ -0,0 +1,438 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_CAPTURE_HPP
+#define LIBNET_CAPTURE_HPP
+
+// Records payloads going through watched sockets into a memory mapped
+// pcapng file that works as a ring buffer, for looking at production
+// traffic without running a packet sniffer.
+//
+// The socket hooks only exist when LIBNET_CAPTURE is defined before
+// including any libnet header, otherwise this costs nothing at all. With
+// it defined, an unarmed tap is a single atomic load per call.
+//
+// Every slot of the ring is a complete pcapng block of the same size, so
+// the file stays readable at any point. Once the ring wraps the packets
+// are no longer in file order, sort them by time (e.g. with reordercap).
+// IP and TCP/UDP headers are synthesized from the socket's addresses.
+// Segmented sends and coalesced receives are recorded as the individual
+// datagrams they stand for. For fast_connect the socket has to be watched
+// before connecting, so only the peer comes from the address it connects to.
+// POSIX only.
+
+#include <net/detail/config.hpp>
+
+#if !defined(LIBNET_WINDOWS)
+#include <net/endpoint.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace net {
+struct capture;
+
+namespace detail {
+inline std::atomic<capture*>& armed_capture() noexcept {
+    static std::atomic<capture*> instance{nullptr};
+    return instance;
+}
+
+enum : uint32_t {
+    pcapng_section_block   = 0x0A0D0D0A,
+    pcapng_interface_block = 0x00000001,
+    pcapng_packet_block    = 0x00000006,
+    pcapng_custom_block    = 0x40000BAD, // marks an unused slot, readers skip it
+    pcapng_linktype_raw    = 101         // raw IPv4 or IPv6 packets
+};
+
+constexpr size_t pcapng_header_size = 28 + 32;
+constexpr size_t pcapng_packet_overhead = 28 + 4;   // block header, fields and trailing length
+constexpr size_t pcapng_synthesized_max = 40 + 20;  // IPv6 header and a TCP header
+
+inline void put16(char* out, uint16_t value) noexcept {
+    std::memcpy(out, &value, sizeof(value));
+}
+
+inline void put32(char* out, uint32_t value) noexcept {
+    std::memcpy(out, &value, sizeof(value));
+}
+
+inline void put16_network(char* out, uint16_t value) noexcept {
+    out[0] = static_cast<char>(value >> 8);
+    out[1] = static_cast<char>(value & 0xFF);
+}
+
+inline void put32_network(char* out, uint32_t value) noexcept {
+    put16_network(out, static_cast<uint16_t>(value >> 16));
+    put16_network(out + 2, static_cast<uint16_t>(value & 0xFFFF));
+}
+} // detail
+
+struct capture {
+public:
+    // bytes_per_slot is rounded up to a multiple of 4 and bounds how much of each
+    // payload is kept. the file is slot_count * bytes_per_slot plus a small header.
+    // only file descriptors below descriptors can be watched.
+    capture(const char* path, size_t slot_count, size_t bytes_per_slot = 2048, size_t descriptors = 4096):
+        base(nullptr), length(0), slots(slot_count), slot_size((bytes_per_slot + 3) & ~size_t(3)),
+        flows(new std::atomic<flow*>[descriptors]), max_descriptors(descriptors), next(0), one_in(1) {
+        if(slots == 0 || slot_size < detail::pcapng_packet_overhead + detail::pcapng_synthesized_max + 8) {
+            throw std::system_error(make_error_code(error::invalid_argument), "capture::capture");
+        }
+
+        for(size_t i = 0; i < max_descriptors; ++i) {
+            flows[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0) {
+            throw std::system_error(std::error_code(error::get_last_error(), error::socket_category()), "capture::capture");
+        }
+
+        length = detail::pcapng_header_size + slots * slot_size;
+        void* ptr = MAP_FAILED;
+        if(::ftruncate(fd, static_cast<off_t>(length)) == 0) {
+            ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+
+        std::error_code ec(error::get_last_error(), error::socket_category());
+        ::close(fd);
+        if(ptr == MAP_FAILED) {
+            throw std::system_error(ec, "capture::capture");
+        }
+
+        base = static_cast<char*>(ptr);
+        write_headers();
+        for(size_t i = 0; i < slots; ++i) {
+            clear_slot(slot(i));
+        }
+    }
+
+    capture(const capture&) = delete;
+    capture& operator=(const capture&) = delete;
+
+    // make sure no socket is still using it, i.e. disarm and let in-flight
+    // calls finish first.
+    ~capture() {
+        disarm();
+        ::munmap(base, length);
+        for(size_t i = 0; i < max_descriptors; ++i) {
+            delete flows[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // makes this the capture the socket hooks write into
+    void arm() noexcept {
+        detail::armed_capture().store(this, std::memory_order_release);
+    }
+
+    void disarm() noexcept {
+        capture* self = this;
+        detail::armed_capture().compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+    }
+
+    // keep one out of every n packets per thread, 1 keeps everything
+    void sample(unsigned n) noexcept {
+        one_in.store(n == 0 ? 1 : n, std::memory_order_relaxed);
+    }
+
+    // starts recording traffic through fd. the addresses are looked up once here,
+    // so call this after the socket is connected (or bound, for datagram sockets).
+    void watch(int fd, std::error_code& ec) noexcept {
+        ec.clear();
+        if(fd < 0 || static_cast<size_t>(fd) >= max_descriptors) {
+            ec = error::invalid_argument;
+            return;
+        }
+
+        std::unique_ptr<flow> created(new (std::nothrow) flow());
+        if(created == nullptr) {
+            ec = error::out_of_memory;
+            return;
+        }
+
+        int type = 0;
+        socklen_t size = sizeof(type);
+        if(::getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &size) != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return;
+        }
+
+        created->tcp = type == SOCK_STREAM;
+        size = endpoint::capacity();
+        if(::getsockname(fd, created->local.data(), &size) == 0) {
+            created->local.resize(size);
+        }
+
+        size = endpoint::capacity();
+        if(::getpeername(fd, created->peer.data(), &size) == 0) {
+            created->peer.resize(size);
+        }
+
+        // descriptors get reused so the old flow is kept around until destruction
+        // in case a hot path is still looking at it.
+        std::lock_guard<std::mutex> lock(retired_mutex);
+        flow* old = flows[fd].exchange(created.get(), std::memory_order_acq_rel);
+        created.release();
+        if(old != nullptr) {
+            retired.emplace_back(old);
+        }
+    }
+
+    void watch(int fd) {
+        std::error_code ec;
+        watch(fd, ec);
+        error::throw_on(ec, "capture::watch");
+    }
+
+    void unwatch(int fd) noexcept {
+        if(fd < 0 || static_cast<size_t>(fd) >= max_descriptors) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(retired_mutex);
+        flow* old = flows[fd].exchange(nullptr, std::memory_order_acq_rel);
+        if(old != nullptr) {
+            retired.emplace_back(old);
+        }
+    }
+
+    // the hot path. peer overrides the watched peer address (e.g. for send_to).
+    void record(int fd, bool outgoing, const char* data, size_t size, const endpoint* peer = nullptr) noexcept {
+        if(fd < 0 || static_cast<size_t>(fd) >= max_descriptors) {
+            return;
+        }
+
+        flow* f = flows[fd].load(std::memory_order_acquire);
+        if(f == nullptr || !sampled()) {
+            return;
+        }
+
+        const endpoint& remote = peer != nullptr ? *peer : f->peer;
+        const endpoint& source = outgoing ? f->local : remote;
+        const endpoint& destination = outgoing ? remote : f->local;
+        uint32_t sequence = 0;
+        if(f->tcp) {
+            auto& counter = outgoing ? f->sent : f->received;
+            sequence = counter.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+        }
+
+        char* out = slot(next.fetch_add(1, std::memory_order_relaxed) % slots);
+        write_packet(out, source, destination, f->tcp, sequence, data, size);
+    }
+
+    size_t slot_count() const noexcept {
+        return slots;
+    }
+private:
+    struct flow {
+        endpoint local;
+        endpoint peer;
+        bool tcp = false;
+        std::atomic<uint32_t> sent{0};
+        std::atomic<uint32_t> received{0};
+    };
+
+    bool sampled() const noexcept {
+        unsigned n = one_in.load(std::memory_order_relaxed);
+        if(n <= 1) {
+            return true;
+        }
+
+        static thread_local unsigned counter = 0;
+        return ++counter % n == 0;
+    }
+
+    char* slot(size_t index) const noexcept {
+        return base + detail::pcapng_header_size + index * slot_size;
+    }
+
+    void write_headers() noexcept {
+        char* out = base;
+        // section header block
+        detail::put32(out, detail::pcapng_section_block);
+        detail::put32(out + 4, 28);
+        detail::put32(out + 8, 0x1A2B3C4D);
+        detail::put16(out + 12, 1);
+        detail::put16(out + 14, 0);
+        std::memset(out + 16, 0xFF, 8); // unknown section length
+        detail::put32(out + 24, 28);
+
+        // interface description block with nanosecond timestamps
+        out += 28;
+        detail::put32(out, detail::pcapng_interface_block);
+        detail::put32(out + 4, 32);
+        detail::put16(out + 8, detail::pcapng_linktype_raw);
+        detail::put16(out + 10, 0);
+        detail::put32(out + 12, static_cast<uint32_t>(slot_size - detail::pcapng_packet_overhead));
+        detail::put16(out + 16, 9);  // if_tsresol
+        detail::put16(out + 18, 1);
+        detail::put32(out + 20, 9);  // 10^-9, padded
+        detail::put32(out + 24, 0);  // opt_endofopt
+        detail::put32(out + 28, 32);
+    }
+
+    void clear_slot(char* out) const noexcept {
+        std::memset(out, 0, slot_size);
+        detail::put32(out, detail::pcapng_custom_block);
+        detail::put32(out + 4, static_cast<uint32_t>(slot_size));
+        detail::put32(out + slot_size - 4, static_cast<uint32_t>(slot_size));
+    }
+
+    static size_t write_network_headers(char* out, const endpoint& source, const endpoint& destination,
+                                        bool tcp, uint32_t sequence, size_t payload) noexcept {
+        size_t transport = tcp ? 20 : 8;
+        bool v6 = source.family() == AF_INET6 || destination.family() == AF_INET6;
+        size_t ip = v6 ? 40 : 20;
+        std::memset(out, 0, ip + transport);
+
+        if(v6) {
+            out[0] = 0x60;
+            detail::put16_network(out + 4, static_cast<uint16_t>(transport + payload));
+            out[6] = static_cast<char>(tcp ? IPPROTO_TCP : IPPROTO_UDP);
+            out[7] = 64;
+            if(source.family() == AF_INET6) {
+                std::memcpy(out + 8, &reinterpret_cast<const sockaddr_in6*>(source.data())->sin6_addr, 16);
+            }
+            if(destination.family() == AF_INET6) {
+                std::memcpy(out + 24, &reinterpret_cast<const sockaddr_in6*>(destination.data())->sin6_addr, 16);
+            }
+        }
+        else {
+            out[0] = 0x45;
+            detail::put16_network(out + 2, static_cast<uint16_t>(std::min<size_t>(ip + transport + payload, 0xFFFF)));
+            out[8] = 64;
+            out[9] = static_cast<char>(tcp ? IPPROTO_TCP : IPPROTO_UDP);
+            if(source.family() == AF_INET) {
+                std::memcpy(out + 12, &reinterpret_cast<const sockaddr_in*>(source.data())->sin_addr, 4);
+            }
+            if(destination.family() == AF_INET) {
+                std::memcpy(out + 16, &reinterpret_cast<const sockaddr_in*>(destination.data())->sin_addr, 4);
+            }
+        }
+
+        char* header = out + ip;
+        detail::put16_network(header, static_cast<uint16_t>(source.port()));
+        detail::put16_network(header + 2, static_cast<uint16_t>(destination.port()));
+        if(tcp) {
+            detail::put32_network(header + 4, sequence);
+            header[12] = 0x50;  // data offset of 5 words
+            header[13] = 0x18;  // PSH, ACK
+            detail::put16_network(header + 14, 0xFFFF);
+        }
+        else {
+            detail::put16_network(header + 4, static_cast<uint16_t>(std::min<size_t>(transport + payload, 0xFFFF)));
+        }
+        return ip + transport;
+    }
+
+    void write_packet(char* out, const endpoint& source, const endpoint& destination,
+                      bool tcp, uint32_t sequence, const char* data, size_t size) const noexcept {
+        // mark the slot unused while it's being written so a reader never
+        // mistakes a half written slot for a packet
+        detail::put32(out, detail::pcapng_custom_block);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        char* packet = out + 28;
+        size_t headers = write_network_headers(packet, source, destination, tcp, sequence, size);
+        size_t room = slot_size - detail::pcapng_packet_overhead - headers;
+        size_t kept = std::min(size, room);
+        std::memcpy(packet + headers, data, kept);
+
+        size_t captured = headers + kept;
+        size_t padded = (captured + 3) & ~size_t(3);
+        std::memset(packet + captured, 0, padded - captured);
+
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto stamp = static_cast<uint64_t>(now);
+        detail::put32(out + 4, static_cast<uint32_t>(slot_size));
+        detail::put32(out + 8, 0);
+        detail::put32(out + 12, static_cast<uint32_t>(stamp >> 32));
+        detail::put32(out + 16, static_cast<uint32_t>(stamp & 0xFFFFFFFF));
+        detail::put32(out + 20, static_cast<uint32_t>(captured));
+        detail::put32(out + 24, static_cast<uint32_t>(headers + size));
+
+        // the rest of the slot is filled with a comment option so every block is the same size
+        char* options = packet + padded;
+        size_t remaining = static_cast<size_t>((out + slot_size - 4) - options);
+        if(remaining >= 8) {
+            detail::put16(options, 1); // opt_comment
+            detail::put16(options + 2, static_cast<uint16_t>(remaining - 8));
+            std::memset(options + 4, 0, remaining - 4);
+        }
+        else if(remaining == 4) {
+            detail::put32(options, 0); // opt_endofopt
+        }
+        detail::put32(out + slot_size - 4, static_cast<uint32_t>(slot_size));
+
+        std::atomic_thread_fence(std::memory_order_release);
+        detail::put32(out, detail::pcapng_packet_block);
+    }
+
+    char* base;
+    size_t length;
+    size_t slots;
+    size_t slot_size;
+    std::unique_ptr<std::atomic<flow*>[]> flows;
+    size_t max_descriptors;
+    std::atomic<uint64_t> next;
+    std::atomic<unsigned> one_in;
+    std::mutex retired_mutex;
+    std::vector<std::unique_ptr<flow>> retired;
+};
+
+namespace detail {
+inline void tap(int fd, bool outgoing, const char* data, size_t size, const endpoint* peer = nullptr) noexcept {
+    capture* armed = armed_capture().load(std::memory_order_acquire);
+    if(armed != nullptr) {
+        armed->record(fd, outgoing, data, size, peer);
+    }
+}
+
+// one record per datagram of a segmented send or coalesced receive
+inline void tap_segments(int fd, bool outgoing, const char* data, size_t size, size_t segment) noexcept {
+    capture* armed = armed_capture().load(std::memory_order_acquire);
+    if(armed == nullptr) {
+        return;
+    }
+
+    if(segment == 0) {
+        segment = size;
+    }
+
+    for(size_t offset = 0; offset < size; offset += segment) {
+        armed->record(fd, outgoing, data + offset, std::min(segment, size - offset));
+    }
+}
+} // detail
+} // net
+
+#endif // LIBNET_WINDOWS
+#endif // LIBNET_CAPTURE_HPP
@@ -28,6 +28,12 @@
 #endif // __CYGWIN__ || _WIN32
 #endif // LIBNET_WINDOWS
 
+#if !defined(LIBNET_LINUX)
+#if defined(__linux__)
+#define LIBNET_LINUX 1
+#endif // __linux__
+#endif // LIBNET_LINUX
+
 // minimise Windows header and disable min and max macros
 #if defined(LIBNET_WINDOWS)
 #if !defined(WIN32_LEAN_AND_MEAN)
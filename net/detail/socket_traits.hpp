@@ -31,6 +31,10 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif // !LIBNET_WINDOWS
 
 namespace net {
@@ -39,19 +43,36 @@ struct socket_traits {
 #if defined(LIBNET_WINDOWS)
     using value_type = SOCKET;
     using getopt_type = char*;
+    using setopt_type = const char*;
+    using length_type = int;
     static constexpr value_type invalid = INVALID_SOCKET;
 
     static inline int close(value_type fd) {
         return ::closesocket(fd);
     }
+
+    static inline int non_blocking(value_type fd, bool enable) {
+        u_long mode = enable ? 1 : 0;
+        return ::ioctlsocket(fd, FIONBIO, &mode);
+    }
 #else
     using value_type = int;
     static constexpr value_type invalid = -1;
     using getopt_type = void*;
+    using setopt_type = const void*;
+    using length_type = socklen_t;
 
     static inline int close(value_type fd) {
         return ::close(fd);
     }
+
+    static inline int non_blocking(value_type fd, bool enable) {
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        if(flags < 0) {
+            return flags;
+        }
+        return ::fcntl(fd, F_SETFL, enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+    }
 #endif // LIBNET_WINDOWS
 };
 } // detail
@@ -0,0 +1,403 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_ENDPOINT_HPP
+#define LIBNET_ENDPOINT_HPP
+
+#include <net/detail/socket_traits.hpp>
+#include <net/detail/string_traits.hpp>
+#include <net/utility.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#if !defined(LIBNET_WINDOWS)
+#include <arpa/inet.h>
+#include <sys/un.h>
+#endif // LIBNET_WINDOWS
+
+namespace net {
+namespace detail {
+struct addrinfo_deleter {
+    void operator()(addrinfo* ptr) const noexcept {
+        if(ptr != nullptr) {
+            ::freeaddrinfo(ptr);
+        }
+    }
+};
+
+// strict dotted quad, i.e. exactly four decimal octets without leading zeroes
+inline bool parse_ipv4(const char* str, size_t size, unsigned char (&out)[4]) noexcept {
+    size_t octet = 0;
+    unsigned value = 0;
+    size_t digits = 0;
+
+    for(size_t i = 0; i < size; ++i) {
+        char c = str[i];
+        if(c >= '0' && c <= '9') {
+            if(digits == 1 && value == 0) {
+                return false;
+            }
+            value = value * 10 + static_cast<unsigned>(c - '0');
+            if(++digits > 3 || value > 255) {
+                return false;
+            }
+        }
+        else if(c == '.') {
+            if(digits == 0 || octet == 3) {
+                return false;
+            }
+            out[octet++] = static_cast<unsigned char>(value);
+            value = 0;
+            digits = 0;
+        }
+        else {
+            return false;
+        }
+    }
+
+    if(digits == 0 || octet != 3) {
+        return false;
+    }
+    out[octet] = static_cast<unsigned char>(value);
+    return true;
+}
+
+inline char* format_octet(char* out, unsigned value) noexcept {
+    if(value >= 100) {
+        *out++ = static_cast<char>('0' + value / 100);
+        value %= 100;
+        *out++ = static_cast<char>('0' + value / 10);
+    }
+    else if(value >= 10) {
+        *out++ = static_cast<char>('0' + value / 10);
+    }
+    *out++ = static_cast<char>('0' + value % 10);
+    return out;
+}
+} // detail
+
+// a resolved socket address. resolve or parse it once and reuse it
+// for as many calls as needed without going through getaddrinfo again.
+struct endpoint {
+public:
+    using length_type = detail::socket_traits::length_type;
+
+    endpoint() noexcept: storage(), length(0) {}
+
+    endpoint(const sockaddr* address, length_type size) noexcept: storage(), length(0) {
+        if(address != nullptr && size > 0 && static_cast<size_t>(size) <= sizeof(storage)) {
+            std::memcpy(&storage, address, static_cast<size_t>(size));
+            length = size;
+        }
+    }
+
+    // numeric addresses only, e.g. "127.0.0.1" or "::1"
+    template<typename String, typename = typename std::enable_if<!std::is_convertible<String, const sockaddr*>::value>::type>
+    endpoint(const String& address, unsigned port): endpoint() {
+        std::error_code ec;
+        *this = parse(address, port, ec);
+        error::throw_on(ec, "endpoint::endpoint");
+    }
+
+    template<typename String>
+    static endpoint parse(const String& address, unsigned port, std::error_code& ec) noexcept {
+        ec.clear();
+        using trait_type = detail::string_traits<String>;
+        const char* str = trait_type::c_str(address);
+        size_t size = trait_type::size(address);
+        endpoint result;
+
+        if(port > 65535) {
+            ec = error::invalid_argument;
+            return result;
+        }
+
+        auto network_port = host_to_network(static_cast<uint16_t>(port));
+        unsigned char octets[4];
+        if(detail::parse_ipv4(str, size, octets)) {
+            auto ptr = reinterpret_cast<sockaddr_in*>(&result.storage);
+            ptr->sin_family = AF_INET;
+            ptr->sin_port = network_port;
+            std::memcpy(&ptr->sin_addr, octets, sizeof(octets));
+            result.length = sizeof(sockaddr_in);
+            return result;
+        }
+
+        // longest textual IPv6 address plus the null terminator
+        char buffer[46];
+        if(size < sizeof(buffer)) {
+            std::memcpy(buffer, str, size);
+            buffer[size] = '\0';
+            auto ptr = reinterpret_cast<sockaddr_in6*>(&result.storage);
+            if(::inet_pton(AF_INET6, buffer, &ptr->sin6_addr) == 1) {
+                ptr->sin6_family = AF_INET6;
+                ptr->sin6_port = network_port;
+                result.length = sizeof(sockaddr_in6);
+                return result;
+            }
+        }
+
+        ec = error::invalid_argument;
+        return endpoint();
+    }
+
+    int family() const noexcept {
+        return length == 0 ? AF_UNSPEC : storage.ss_family;
+    }
+
+    unsigned port() const noexcept {
+        switch(family()) {
+        case AF_INET:
+            return network_to_host(reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+        case AF_INET6:
+            return network_to_host(reinterpret_cast<const sockaddr_in6*>(&storage)->sin6_port);
+        default:
+            return 0;
+        }
+    }
+
+    // the address without the port
+    std::string address() const {
+        switch(family()) {
+        case AF_INET: {
+            auto bytes = reinterpret_cast<const unsigned char*>(&reinterpret_cast<const sockaddr_in*>(&storage)->sin_addr);
+            char buffer[16];
+            char* out = buffer;
+            for(int i = 0; i < 4; ++i) {
+                if(i != 0) {
+                    *out++ = '.';
+                }
+                out = detail::format_octet(out, bytes[i]);
+            }
+            return std::string(buffer, out);
+        }
+        case AF_INET6: {
+            char buffer[46];
+            auto ptr = reinterpret_cast<const sockaddr_in6*>(&storage);
+            if(::inet_ntop(AF_INET6, const_cast<in6_addr*>(&ptr->sin6_addr), buffer, sizeof(buffer)) == nullptr) {
+                return {};
+            }
+            return buffer;
+        }
+    #if !defined(LIBNET_WINDOWS)
+        case AF_UNIX: {
+            auto ptr = reinterpret_cast<const sockaddr_un*>(&storage);
+            size_t offset = offsetof(sockaddr_un, sun_path);
+            if(static_cast<size_t>(length) <= offset) {
+                return {};
+            }
+            // abstract addresses start with a null byte and aren't null terminated
+            size_t size = static_cast<size_t>(length) - offset;
+            if(ptr->sun_path[0] != '\0') {
+                size = ::strnlen(ptr->sun_path, size);
+            }
+            return std::string(ptr->sun_path, size);
+        }
+    #endif // LIBNET_WINDOWS
+        default:
+            return {};
+        }
+    }
+
+    // e.g. "127.0.0.1:80" or "[::1]:80"
+    std::string to_string() const {
+        auto result = address();
+        switch(family()) {
+        case AF_INET:
+            return result + ':' + std::to_string(port());
+        case AF_INET6:
+            return '[' + result + "]:" + std::to_string(port());
+        default:
+            return result;
+        }
+    }
+
+    const sockaddr* data() const noexcept {
+        return reinterpret_cast<const sockaddr*>(&storage);
+    }
+
+    sockaddr* data() noexcept {
+        return reinterpret_cast<sockaddr*>(&storage);
+    }
+
+    length_type size() const noexcept {
+        return length;
+    }
+
+    static constexpr length_type capacity() noexcept {
+        return sizeof(sockaddr_storage);
+    }
+
+    // to be called after the storage was filled in through data(), e.g. by accept
+    void resize(length_type new_size) noexcept {
+        length = new_size > capacity() ? capacity() : new_size;
+    }
+
+    explicit operator bool() const noexcept {
+        return length != 0;
+    }
+
+    size_t hash() const noexcept {
+        // FNV-1a over the significant bytes
+        uint64_t result = 14695981039346656037ULL;
+        auto mix = [&result](const void* ptr, size_t size) {
+            auto bytes = static_cast<const unsigned char*>(ptr);
+            for(size_t i = 0; i < size; ++i) {
+                result = (result ^ bytes[i]) * 1099511628211ULL;
+            }
+        };
+
+        auto fam = family();
+        mix(&fam, sizeof(fam));
+        switch(fam) {
+        case AF_INET: {
+            auto ptr = reinterpret_cast<const sockaddr_in*>(&storage);
+            mix(&ptr->sin_addr, sizeof(ptr->sin_addr));
+            mix(&ptr->sin_port, sizeof(ptr->sin_port));
+            break;
+        }
+        case AF_INET6: {
+            auto ptr = reinterpret_cast<const sockaddr_in6*>(&storage);
+            mix(&ptr->sin6_addr, sizeof(ptr->sin6_addr));
+            mix(&ptr->sin6_port, sizeof(ptr->sin6_port));
+            mix(&ptr->sin6_scope_id, sizeof(ptr->sin6_scope_id));
+            break;
+        }
+        default:
+            mix(&storage, static_cast<size_t>(length));
+            break;
+        }
+        return static_cast<size_t>(result);
+    }
+
+    friend bool operator==(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) == 0;
+    }
+
+    friend bool operator!=(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) != 0;
+    }
+
+    friend bool operator<(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) < 0;
+    }
+
+    friend bool operator<=(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) <= 0;
+    }
+
+    friend bool operator>(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) > 0;
+    }
+
+    friend bool operator>=(const endpoint& lhs, const endpoint& rhs) noexcept {
+        return lhs.compare(rhs) >= 0;
+    }
+private:
+    // orders by family, then address, then port so ignoring any padding
+    int compare(const endpoint& other) const noexcept {
+        int lhs_family = family();
+        int rhs_family = other.family();
+        if(lhs_family != rhs_family) {
+            return lhs_family < rhs_family ? -1 : 1;
+        }
+
+        int result = 0;
+        switch(lhs_family) {
+        case AF_INET: {
+            auto lhs = reinterpret_cast<const sockaddr_in*>(&storage);
+            auto rhs = reinterpret_cast<const sockaddr_in*>(&other.storage);
+            result = std::memcmp(&lhs->sin_addr, &rhs->sin_addr, sizeof(lhs->sin_addr));
+            break;
+        }
+        case AF_INET6: {
+            auto lhs = reinterpret_cast<const sockaddr_in6*>(&storage);
+            auto rhs = reinterpret_cast<const sockaddr_in6*>(&other.storage);
+            result = std::memcmp(&lhs->sin6_addr, &rhs->sin6_addr, sizeof(lhs->sin6_addr));
+            if(result == 0 && lhs->sin6_scope_id != rhs->sin6_scope_id) {
+                result = lhs->sin6_scope_id < rhs->sin6_scope_id ? -1 : 1;
+            }
+            break;
+        }
+        default:
+            if(length != other.length) {
+                return length < other.length ? -1 : 1;
+            }
+            return std::memcmp(&storage, &other.storage, static_cast<size_t>(length));
+        }
+
+        if(result != 0) {
+            return result;
+        }
+
+        unsigned lhs_port = port();
+        unsigned rhs_port = other.port();
+        return lhs_port == rhs_port ? 0 : (lhs_port < rhs_port ? -1 : 1);
+    }
+
+    sockaddr_storage storage;
+    length_type length;
+};
+
+// resolves host once, returning the first address found.
+template<typename String>
+inline endpoint resolve(const String& host, unsigned port, int family, int type, std::error_code& ec) noexcept {
+    ec.clear();
+    auto hints = addrinfo();
+    hints.ai_family = family;
+    hints.ai_socktype = type;
+
+    auto port_str = std::to_string(port);
+    addrinfo* ptr = nullptr;
+    int ret = ::getaddrinfo(detail::string_traits<String>::c_str(host), port_str.c_str(), &hints, &ptr);
+
+    if(ret != 0) {
+        ec.assign(ret, error::getaddrinfo_category());
+        return {};
+    }
+
+    std::unique_ptr<addrinfo, detail::addrinfo_deleter> res(ptr);
+    return { ptr->ai_addr, static_cast<endpoint::length_type>(ptr->ai_addrlen) };
+}
+
+template<typename String>
+inline endpoint resolve(const String& host, unsigned port, int family = AF_UNSPEC, int type = SOCK_STREAM) {
+    std::error_code ec;
+    auto&& result = resolve(host, port, family, type, ec);
+    error::throw_on(ec, "net::resolve");
+    return result;
+}
+} // net
+
+namespace std {
+template <>
+struct hash<net::endpoint> {
+    size_t operator()(const net::endpoint& value) const noexcept {
+        return value.hash();
+    }
+};
+} // std
+
+#endif // LIBNET_ENDPOINT_HPP
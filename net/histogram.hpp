@@ -0,0 +1,148 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_HISTOGRAM_HPP
+#define LIBNET_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace net {
+// A log-linear histogram for latencies. every power of two range is split
+// into 64 buckets so recorded values are off by at most ~1.6%, with a fixed
+// amount of memory no matter the range of values.
+struct histogram {
+public:
+    histogram(): counts(bucket_count, 0), total(0), sum(0),
+                 lowest(std::numeric_limits<uint64_t>::max()), highest(0) {}
+
+    void record(uint64_t value, uint64_t count = 1) noexcept {
+        counts[index_of(value)] += count;
+        total += count;
+        sum += value * count;
+        lowest = std::min(lowest, value);
+        highest = std::max(highest, value);
+    }
+
+    template<typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> value) noexcept {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+        record(ns < 0 ? 0 : static_cast<uint64_t>(ns));
+    }
+
+    void merge(const histogram& other) noexcept {
+        for(size_t i = 0; i < bucket_count; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        lowest = std::min(lowest, other.lowest);
+        highest = std::max(highest, other.highest);
+    }
+
+    void reset() noexcept {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        sum = 0;
+        lowest = std::numeric_limits<uint64_t>::max();
+        highest = 0;
+    }
+
+    uint64_t count() const noexcept {
+        return total;
+    }
+
+    uint64_t min() const noexcept {
+        return total == 0 ? 0 : lowest;
+    }
+
+    uint64_t max() const noexcept {
+        return highest;
+    }
+
+    double mean() const noexcept {
+        return total == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(total);
+    }
+
+    // the value at or below which the given percentage (0 to 100) of
+    // recorded values fall.
+    uint64_t percentile(double p) const noexcept {
+        if(total == 0) {
+            return 0;
+        }
+
+        p = std::min(std::max(p, 0.0), 100.0);
+        auto wanted = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+        wanted = std::max<uint64_t>(wanted, 1);
+
+        uint64_t seen = 0;
+        for(size_t i = 0; i < bucket_count; ++i) {
+            seen += counts[i];
+            if(seen >= wanted) {
+                return std::min(std::max(highest_in(i), lowest), highest);
+            }
+        }
+        return highest;
+    }
+private:
+    static constexpr unsigned sub_bits = 6;
+    static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+    static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+    static unsigned log2(uint64_t value) noexcept {
+        unsigned result = 0;
+        while(value >>= 1) {
+            ++result;
+        }
+        return result;
+    }
+
+    static size_t index_of(uint64_t value) noexcept {
+        if(value < sub_count) {
+            return static_cast<size_t>(value);
+        }
+
+        unsigned shift = log2(value) - sub_bits;
+        return static_cast<size_t>((shift + 1) * sub_count + ((value >> shift) - sub_count));
+    }
+
+    static uint64_t highest_in(size_t index) noexcept {
+        if(index < sub_count) {
+            return index;
+        }
+
+        unsigned shift = static_cast<unsigned>(index / sub_count - 1);
+        uint64_t base = (index % sub_count + sub_count) << shift;
+        return base + ((uint64_t(1) << shift) - 1);
+    }
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t sum;
+    uint64_t lowest;
+    uint64_t highest;
+};
+} // net
+
+#endif // LIBNET_HISTOGRAM_HPP
@@ -0,0 +1,213 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_RELAY_HPP
+#define LIBNET_RELAY_HPP
+
+// Moves bytes between two connected stream sockets in both directions
+// using splice(2) through a kernel pipe, so the data never gets copied
+// into user space. Linux only.
+
+#include <net/detail/config.hpp>
+
+#if defined(LIBNET_LINUX)
+#include <net/socket.hpp>
+#include <atomic>
+#include <cstdint>
+#include <fcntl.h>
+#include <poll.h>
+
+namespace net {
+struct relay {
+public:
+    // pipe_size is the most data that can be in flight per direction,
+    // 0 keeps the kernel default (usually 64 KiB).
+    relay(const socket& first, const socket& second, size_t pipe_size = 0): ends{ first.native_handle(), second.native_handle() } {
+        std::error_code ec;
+        for(auto& dir : directions) {
+            dir.pipe[0] = dir.pipe[1] = -1;
+        }
+
+        for(auto& dir : directions) {
+            if(::pipe2(dir.pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                break;
+            }
+
+            if(pipe_size != 0) {
+                ::fcntl(dir.pipe[1], F_SETPIPE_SZ, static_cast<int>(pipe_size));
+            }
+
+            int capacity = ::fcntl(dir.pipe[1], F_GETPIPE_SZ);
+            dir.capacity = capacity > 0 ? static_cast<size_t>(capacity) : 65536;
+        }
+
+        if(ec) {
+            close_pipes();
+            throw std::system_error(ec, "relay::relay");
+        }
+    }
+
+    relay(const relay&) = delete;
+    relay& operator=(const relay&) = delete;
+
+    ~relay() {
+        close_pipes();
+    }
+
+    // runs until both directions have reached end of file or an error occurs.
+    // when one side stops sending, the other side is shut down for sending too
+    // once the pipe is drained (half-close) while the opposite direction keeps going.
+    // both sockets are put into non-blocking mode.
+    void run(std::error_code& ec) noexcept {
+        ec.clear();
+        for(auto fd : ends) {
+            if(detail::socket_traits::non_blocking(fd, true) == -1) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                return;
+            }
+        }
+
+        while(!directions[0].finished() || !directions[1].finished()) {
+            pollfd fds[2];
+            for(int i = 0; i < 2; ++i) {
+                auto& incoming = directions[i];      // reads from ends[i]
+                auto& outgoing = directions[i ^ 1];  // writes to ends[i]
+                fds[i].fd = ends[i];
+                fds[i].events = 0;
+                fds[i].revents = 0;
+                if(!incoming.eof && incoming.pending < incoming.capacity) {
+                    fds[i].events |= POLLIN;
+                }
+                if(outgoing.pending > 0) {
+                    fds[i].events |= POLLOUT;
+                }
+            }
+
+            if(::poll(fds, 2, -1) < 0) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                if(ec == error::interrupted) {
+                    continue;
+                }
+                return;
+            }
+
+            for(int i = 0; i < 2; ++i) {
+                if(!pump(directions[i], ends[i], ends[i ^ 1], ec)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    void run() {
+        std::error_code ec;
+        run(ec);
+        error::throw_on(ec, "relay::run");
+    }
+
+    // bytes delivered from the first socket to the second
+    uint64_t forwarded() const noexcept {
+        return directions[0].bytes.load(std::memory_order_relaxed);
+    }
+
+    // bytes delivered from the second socket to the first
+    uint64_t returned() const noexcept {
+        return directions[1].bytes.load(std::memory_order_relaxed);
+    }
+private:
+    struct direction {
+        int pipe[2];
+        size_t capacity = 0;
+        size_t pending = 0;  // bytes sitting in the pipe
+        std::atomic<uint64_t> bytes{0};
+        bool eof = false;
+        bool shut = false;
+
+        bool finished() const noexcept {
+            return eof && pending == 0 && shut;
+        }
+    };
+
+    // moves as much as possible from source into the pipe and from the pipe
+    // into destination without blocking. returns false on a hard error.
+    static bool pump(direction& dir, int source, int destination, std::error_code& ec) noexcept {
+        constexpr unsigned flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+        if(!dir.eof && dir.pending < dir.capacity) {
+            auto ret = ::splice(source, nullptr, dir.pipe[1], nullptr, dir.capacity - dir.pending, flags);
+            if(ret > 0) {
+                dir.pending += static_cast<size_t>(ret);
+            }
+            else if(ret == 0) {
+                dir.eof = true;
+            }
+            else if(!would_block()) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                return false;
+            }
+        }
+
+        while(dir.pending > 0) {
+            auto ret = ::splice(dir.pipe[0], nullptr, destination, nullptr, dir.pending, flags | (dir.eof ? 0 : SPLICE_F_MORE));
+            if(ret > 0) {
+                dir.pending -= static_cast<size_t>(ret);
+                dir.bytes.fetch_add(static_cast<uint64_t>(ret), std::memory_order_relaxed);
+                continue;
+            }
+
+            if(ret < 0 && !would_block()) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                return false;
+            }
+            break; // backpressure, wait for the destination to become writable
+        }
+
+        if(dir.eof && dir.pending == 0 && !dir.shut) {
+            ::shutdown(destination, SHUT_WR);
+            dir.shut = true;
+        }
+        return true;
+    }
+
+    static bool would_block() noexcept {
+        int err = error::get_last_error();
+        return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+    }
+
+    void close_pipes() noexcept {
+        for(auto& dir : directions) {
+            for(auto& fd : dir.pipe) {
+                if(fd != -1) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+        }
+    }
+
+    int ends[2];
+    direction directions[2];
+};
+} // net
+
+#endif // LIBNET_LINUX
+#endif // LIBNET_RELAY_HPP
@@ -0,0 +1,545 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_SHM_CHANNEL_HPP
+#define LIBNET_SHM_CHANNEL_HPP
+
+// A same-host transport between two processes over a pair of single producer,
+// single consumer ring buffers in a memfd. Waiting is done by spinning for a
+// while and then sleeping on a futex so idle peers don't burn a core.
+//
+// Each side is owned by the process that created or attached it, and only
+// closing it in that process tells the peer the channel is shut down. Copies
+// inherited through fork just unmap, the same way closing an inherited socket
+// descriptor doesn't end the connection. A peer that exits without closing
+// (e.g. it crashed) is noticed within shm_liveness_interval of a blocking call,
+// or on the next non-blocking call that would otherwise fail with would_block,
+// and treated as if it had closed. Both processes have to share a pid
+// namespace for that. Linux only.
+
+#include <net/detail/config.hpp>
+
+#if defined(LIBNET_LINUX)
+#include <net/detail/string_traits.hpp>
+#include <net/error.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <linux/futex.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace net {
+namespace detail {
+constexpr size_t shm_cache_line = 64;
+constexpr uint64_t shm_magic = 0x6C69626E65747368; // "libnetsh"
+constexpr long shm_liveness_interval = 100000000;   // nanoseconds between checks on a sleeping peer
+
+enum : uint32_t {
+    shm_producer_closed = 1,
+    shm_consumer_closed = 2
+};
+
+struct shm_ring {
+    // owned by the producer
+    alignas(shm_cache_line) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> readable;         // futex word bumped when data is published
+    std::atomic<uint32_t> consumer_waiting;
+
+    // owned by the consumer
+    alignas(shm_cache_line) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> writable;         // futex word bumped when space is freed
+    std::atomic<uint32_t> producer_waiting;
+
+    alignas(shm_cache_line) std::atomic<uint32_t> closed;
+};
+
+struct shm_header {
+    uint64_t magic;
+    uint64_t capacity;
+    std::atomic<uint32_t> attached;
+    std::atomic<int32_t> owners[2];  // pid of the process owning each side
+    shm_ring rings[2];
+};
+
+constexpr size_t shm_data_offset = (sizeof(shm_header) + 4095) & ~size_t(4095);
+
+// returns false if the timeout expired
+inline bool futex_wait(std::atomic<uint32_t>& word, uint32_t expected, long timeout_ns) noexcept {
+    timespec timeout;
+    timeout.tv_sec = timeout_ns / 1000000000;
+    timeout.tv_nsec = timeout_ns % 1000000000;
+    auto ret = ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    return ret == 0 || errno != ETIMEDOUT;
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+inline int pidfd_open(int pid) noexcept {
+#if defined(SYS_pidfd_open)
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif // SYS_pidfd_open
+}
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+} // detail
+
+struct shm_channel {
+public:
+    using native_type = int;
+    static constexpr native_type invalid = -1;
+
+    shm_channel() noexcept: fd(invalid), header(nullptr), size(0), side(0), spin_limit(min_spin), peer(invalid) {}
+
+    // creates a new channel with the given capacity in bytes per direction.
+    // the other process attaches to native_handle() after inheriting it
+    // through fork or receiving it over a unix socket.
+    explicit shm_channel(size_t capacity): shm_channel() {
+        std::error_code ec;
+        create(capacity, ec);
+        error::throw_on(ec, "shm_channel::shm_channel");
+    }
+
+    shm_channel(const shm_channel&) = delete;
+    shm_channel& operator=(const shm_channel&) = delete;
+
+    shm_channel(shm_channel&& other) noexcept: shm_channel() {
+        swap(other);
+    }
+
+    shm_channel& operator=(shm_channel&& other) noexcept {
+        shm_channel temp(std::move(other));
+        swap(temp);
+        return *this;
+    }
+
+    ~shm_channel() {
+        std::error_code ec;
+        close(ec);
+    }
+
+    // attaches to the other end of a channel. takes ownership of fd.
+    static shm_channel attach(native_type fd, std::error_code& ec) noexcept {
+        ec.clear();
+        shm_channel result;
+        result.fd = fd;
+
+        struct stat info;
+        if(::fstat(fd, &info) != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return result;
+        }
+
+        if(static_cast<size_t>(info.st_size) < detail::shm_data_offset) {
+            ec = error::invalid_argument;
+            return result;
+        }
+
+        if(!result.map(static_cast<size_t>(info.st_size), ec)) {
+            return result;
+        }
+
+        auto expected_size = detail::shm_data_offset + 2 * result.header->capacity;
+        if(result.header->magic != detail::shm_magic || expected_size != result.size) {
+            ec = error::invalid_argument;
+            return result;
+        }
+
+        uint32_t unclaimed = 0;
+        if(!result.header->attached.compare_exchange_strong(unclaimed, 1)) {
+            ec = error::already_connected;
+            return result;
+        }
+
+        result.side = 1;
+        result.header->owners[1].store(static_cast<int32_t>(::getpid()), std::memory_order_release);
+        return result;
+    }
+
+    static shm_channel attach(native_type fd) {
+        std::error_code ec;
+        auto&& result = attach(fd, ec);
+        error::throw_on(ec, "shm_channel::attach");
+        return std::move(result);
+    }
+
+    native_type native_handle() const noexcept {
+        return fd;
+    }
+
+    size_t capacity() const noexcept {
+        return header != nullptr ? static_cast<size_t>(header->capacity) : 0;
+    }
+
+    void close(std::error_code& ec) noexcept {
+        ec.clear();
+        if(header != nullptr) {
+            // a copy inherited through fork doesn't own the side
+            if(header->owners[side].load(std::memory_order_acquire) == static_cast<int32_t>(::getpid())) {
+                shutdown(sending_ring(), detail::shm_producer_closed);
+                shutdown(receiving_ring(), detail::shm_consumer_closed);
+            }
+            ::munmap(header, size);
+            header = nullptr;
+            size = 0;
+        }
+
+        if(fd != invalid) {
+            if(::close(fd) != 0) {
+                ec.assign(error::get_last_error(), error::socket_category());
+            }
+            fd = invalid;
+        }
+
+        if(peer != invalid) {
+            ::close(peer);
+            peer = invalid;
+        }
+    }
+
+    void close() {
+        std::error_code ec;
+        close(ec);
+        error::throw_on(ec, "shm_channel::close");
+    }
+
+    // blocks until everything is written unless MSG_DONTWAIT is given, in which
+    // case it writes what fits.
+    template<typename String>
+    int send(const String& str, int flags, std::error_code& ec) noexcept {
+        ec.clear();
+        if(header == nullptr) {
+            ec = error::bad_descriptor;
+            return 0;
+        }
+
+        using trait_type = detail::string_traits<String>;
+        const char* data = trait_type::c_str(str);
+        size_t length = trait_type::size(str);
+
+        auto& ring = sending_ring();
+        char* buffer = sending_buffer();
+        uint64_t capacity = header->capacity;
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        size_t written = 0;
+
+        while(written < length) {
+            if(ring.closed.load(std::memory_order_acquire) & detail::shm_consumer_closed) {
+                ec = error::broken_pipe;
+                break;
+            }
+
+            uint64_t tail = ring.tail.load(std::memory_order_acquire);
+            size_t available = static_cast<size_t>(capacity - (head - tail));
+            if(available == 0) {
+                if(flags & MSG_DONTWAIT) {
+                    if(peer_exited()) {
+                        continue; // reported as broken_pipe above
+                    }
+                    if(written == 0) {
+                        ec = error::would_block;
+                    }
+                    break;
+                }
+
+                wait(ring.writable, ring.producer_waiting, [&ring, head, capacity] {
+                    return head - ring.tail.load(std::memory_order_acquire) < capacity ||
+                           (ring.closed.load(std::memory_order_acquire) & detail::shm_consumer_closed);
+                });
+                continue;
+            }
+
+            size_t count = std::min(available, length - written);
+            copy_in(buffer, head, data + written, count);
+            head += count;
+            written += count;
+            ring.head.store(head, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            notify(ring.readable, ring.consumer_waiting);
+        }
+
+        return static_cast<int>(written);
+    }
+
+    template<typename String>
+    int send(const String& str, int flags = 0) {
+        std::error_code ec;
+        int result = send(str, flags, ec);
+        error::throw_on(ec, "shm_channel::send");
+        return result;
+    }
+
+    // blocks until at least one byte is available unless MSG_DONTWAIT is given.
+    // an empty result with no error means the other end has closed.
+    std::string receive(int buffer_size, int flags, std::error_code& ec) noexcept {
+        ec.clear();
+        if(header == nullptr) {
+            ec = error::bad_descriptor;
+            return {};
+        }
+
+        if(buffer_size == 0) {
+            return {}; // requested nothing so just exit.
+        }
+
+        auto& ring = receiving_ring();
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+
+        if(head == tail) {
+            // a closed peer is end of file, even for a non-blocking read
+            if(!(ring.closed.load(std::memory_order_acquire) & detail::shm_producer_closed)) {
+                if(flags & MSG_DONTWAIT) {
+                    if(!peer_exited()) {
+                        ec = error::would_block;
+                        return {};
+                    }
+                }
+                else {
+                    wait(ring.readable, ring.consumer_waiting, [&ring, &head, tail] {
+                    head = ring.head.load(std::memory_order_acquire);
+                        return head != tail || (ring.closed.load(std::memory_order_acquire) & detail::shm_producer_closed);
+                    });
+                }
+            }
+
+            // the producer may have written right before closing
+            head = ring.head.load(std::memory_order_acquire);
+            if(head == tail) {
+                return {};
+            }
+        }
+
+        size_t count = std::min(static_cast<size_t>(head - tail), static_cast<size_t>(buffer_size));
+        std::string result;
+        if(!error::safely_invoke([&result, count] { result.resize(count); }, ec)) {
+            return {};
+        }
+
+        copy_out(receiving_buffer(), tail, &result[0], count);
+        if(!(flags & MSG_PEEK)) {
+            ring.tail.store(tail + count, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            notify(ring.writable, ring.producer_waiting);
+        }
+        return result;
+    }
+
+    std::string receive(int buffer_size, int flags = 0) {
+        std::error_code ec;
+        auto&& result = receive(buffer_size, flags, ec);
+        error::throw_on(ec, "shm_channel::receive");
+        return result;
+    }
+
+    void swap(shm_channel& other) noexcept {
+        std::swap(fd, other.fd);
+        std::swap(header, other.header);
+        std::swap(size, other.size);
+        std::swap(side, other.side);
+        std::swap(spin_limit, other.spin_limit);
+        std::swap(peer, other.peer);
+    }
+private:
+    enum : int {
+        min_spin = 64,
+        max_spin = 16384
+    };
+
+    void create(size_t capacity, std::error_code& ec) noexcept {
+        ec.clear();
+        // round up to a power of two so wrapping is a mask
+        size_t rounded = 4096;
+        while(rounded < capacity) {
+            rounded <<= 1;
+        }
+
+        fd = ::memfd_create("libnet.shm_channel", MFD_CLOEXEC);
+        if(fd == invalid) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return;
+        }
+
+        size_t total = detail::shm_data_offset + 2 * rounded;
+        if(::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return;
+        }
+
+        if(!map(total, ec)) {
+            return;
+        }
+
+        // the memfd starts zeroed, this just begins the lifetime of the objects.
+        header = new (header) detail::shm_header();
+        header->capacity = rounded;
+        header->owners[0].store(static_cast<int32_t>(::getpid()), std::memory_order_relaxed);
+        header->magic = detail::shm_magic;
+    }
+
+    bool map(size_t total, std::error_code& ec) noexcept {
+        void* ptr = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(ptr == MAP_FAILED) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return false;
+        }
+
+        header = static_cast<detail::shm_header*>(ptr);
+        size = total;
+        return true;
+    }
+
+    detail::shm_ring& sending_ring() const noexcept {
+        return header->rings[side];
+    }
+
+    detail::shm_ring& receiving_ring() const noexcept {
+        return header->rings[side ^ 1];
+    }
+
+    char* sending_buffer() const noexcept {
+        return reinterpret_cast<char*>(header) + detail::shm_data_offset + side * header->capacity;
+    }
+
+    char* receiving_buffer() const noexcept {
+        return reinterpret_cast<char*>(header) + detail::shm_data_offset + (side ^ 1) * header->capacity;
+    }
+
+    void copy_in(char* buffer, uint64_t position, const char* data, size_t count) const noexcept {
+        size_t offset = static_cast<size_t>(position & (header->capacity - 1));
+        size_t first = std::min(count, static_cast<size_t>(header->capacity) - offset);
+        std::memcpy(buffer + offset, data, first);
+        std::memcpy(buffer, data + first, count - first);
+    }
+
+    void copy_out(const char* buffer, uint64_t position, char* data, size_t count) const noexcept {
+        size_t offset = static_cast<size_t>(position & (header->capacity - 1));
+        size_t first = std::min(count, static_cast<size_t>(header->capacity) - offset);
+        std::memcpy(data, buffer + offset, first);
+        std::memcpy(data + first, buffer, count - first);
+    }
+
+    static void notify(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiting) noexcept {
+        // pairs with the store to waiting in wait(), either the waiter sees our
+        // update or we see that it's asleep.
+        if(waiting.load(std::memory_order_seq_cst) != 0) {
+            word.fetch_add(1, std::memory_order_release);
+            detail::futex_wake(word);
+        }
+    }
+
+    // checks whether the process owning the other side has exited, and if so
+    // closes its side on its behalf. before the other side attaches there's
+    // nobody to check. a pidfd also catches a peer that's a zombie child of ours,
+    // without one kill(2) has to do.
+    bool peer_exited() noexcept {
+        int pid = header->owners[side ^ 1].load(std::memory_order_acquire);
+        if(pid <= 0) {
+            return false;
+        }
+
+        bool exited = false;
+        if(peer == invalid) {
+            peer = detail::pidfd_open(pid);
+        }
+
+        if(peer != invalid) {
+            pollfd process = { peer, POLLIN, 0 };
+            exited = ::poll(&process, 1, 0) > 0;
+        }
+        else {
+            exited = errno == ESRCH || (::kill(pid, 0) != 0 && errno == ESRCH);
+        }
+
+        if(exited) {
+            shutdown(sending_ring(), detail::shm_consumer_closed);
+            shutdown(receiving_ring(), detail::shm_producer_closed);
+        }
+        return exited;
+    }
+
+    static void shutdown(detail::shm_ring& ring, uint32_t flag) noexcept {
+        ring.closed.fetch_or(flag, std::memory_order_seq_cst);
+        ring.readable.fetch_add(1, std::memory_order_release);
+        ring.writable.fetch_add(1, std::memory_order_release);
+        detail::futex_wake(ring.readable);
+        detail::futex_wake(ring.writable);
+    }
+
+    // spins for a while then sleeps on the futex word. the spin budget grows
+    // when spinning pays off and shrinks when we end up sleeping anyway.
+    // the sleep is bounded so a peer that died without closing is noticed.
+    template<typename Predicate>
+    void wait(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiting, Predicate ready) noexcept {
+        for(int i = 0; i < spin_limit; ++i) {
+            if(ready()) {
+                spin_limit = std::min<int>(max_spin, spin_limit * 2);
+                return;
+            }
+            detail::cpu_relax();
+        }
+
+        spin_limit = std::max<int>(min_spin, spin_limit / 2);
+        while(true) {
+            uint32_t sequence = word.load(std::memory_order_acquire);
+            waiting.store(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(ready()) {
+                break;
+            }
+            if(!detail::futex_wait(word, sequence, detail::shm_liveness_interval)) {
+                peer_exited();
+            }
+        }
+        waiting.store(0, std::memory_order_relaxed);
+    }
+
+    native_type fd;
+    detail::shm_header* header;
+    size_t size;
+    unsigned side;
+    int spin_limit;
+    int peer;  // pidfd of the process owning the other side, opened on demand
+};
+} // net
+
+#endif // LIBNET_LINUX
+#endif // LIBNET_SHM_CHANNEL_HPP
@@ -24,17 +24,53 @@
 
 #include <net/detail/socket_traits.hpp>
 #include <net/detail/string_traits.hpp>
+#include <net/endpoint.hpp>
+#include <net/bpf.hpp>
+#include <net/timestamp.hpp>
+#if defined(LIBNET_CAPTURE)
+#include <net/capture.hpp>
+#endif // LIBNET_CAPTURE
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 
 namespace net {
 namespace detail {
-struct addrinfo_deleter {
-    void operator()(addrinfo* ptr) const noexcept {
-        if(ptr != nullptr) {
-            ::freeaddrinfo(ptr);
+// used to disambiguate adopting an existing descriptor from creating a new one
+struct adopt_t {};
+
+#if defined(UDP_SEGMENT)
+// the kernel refuses more segments than this in a single GSO send
+constexpr size_t max_gso_segments = 64;
+constexpr size_t max_gso_payload = 65507;
+
+// support for UDP_SEGMENT is a property of the kernel rather than the socket,
+// so the probe is done once per process on a UDP socket of its own.
+inline bool udp_segmentation_supported() noexcept {
+    static const bool supported = [] {
+        int probe = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if(probe < 0) {
+            probe = ::socket(AF_INET6, SOCK_DGRAM, 0);
         }
-    }
-};
+        if(probe < 0) {
+            return false;
+        }
+
+        int value = 0;
+        socklen_t len = sizeof(value);
+        bool result = ::getsockopt(probe, SOL_UDP, UDP_SEGMENT, &value, &len) == 0;
+        ::close(probe);
+        return result;
+    }();
+    return supported;
+}
+
+// errors that signify the offload path isn't usable, e.g. the device lacks
+// checksum offload, as opposed to a genuine failure to send.
+inline bool offload_unsupported(const std::error_code& ec) noexcept {
+    return ec == error::protocol_unavailable || ec == error::operation_not_supported || ec.value() == EIO;
+}
+#endif // UDP_SEGMENT
 } // detail
 
 namespace message {
@@ -45,6 +81,21 @@ enum : int {
     wait_all    = MSG_WAITALL
 };
 } // message
+
+namespace direction {
+enum : int {
+#if defined(LIBNET_WINDOWS)
+    receive = SD_RECEIVE,
+    send    = SD_SEND,
+    both    = SD_BOTH
+#else
+    receive = SHUT_RD,
+    send    = SHUT_WR,
+    both    = SHUT_RDWR
+#endif // LIBNET_WINDOWS
+};
+} // direction
+
 struct socket {
 public:
     using native_type = detail::socket_traits::value_type;
@@ -62,7 +113,7 @@ public:
         ipv6 = PF_INET6
     };
 
-    socket(): fd(invalid) {}
+    socket(): fd(invalid), protocol(unspecified) {}
     socket(int protocol, int type = socket::stream, int ip_proto = 0): fd(::socket(protocol, type, ip_proto)), protocol(protocol) {
         if(fd == invalid) {
             std::error_code ec{error::get_last_error(), error::socket_category()};
@@ -73,12 +124,13 @@ public:
     socket(const socket&) = delete;
     socket& operator=(const socket&) = delete;
 
-    socket(socket&& other): fd(other.fd) {
+    socket(socket&& other): fd(other.fd), protocol(other.protocol) {
         other.fd = invalid;
     }
 
     socket& operator=(socket&& other) {
         fd = other.fd;
+        protocol = other.protocol;
         other.fd = invalid;
         return *this;
     }
@@ -106,6 +158,99 @@ public:
         error::throw_on(ec, "socket::close");
     }
 
+    native_type native_handle() const noexcept {
+        return fd;
+    }
+
+    // stops further sends, receives or both (see net::direction)
+    void shutdown(int how, std::error_code& ec) const noexcept {
+        ec.clear();
+        int ret = ::shutdown(fd, how);
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    void shutdown(int how = direction::both) const {
+        std::error_code ec;
+        shutdown(how, ec);
+        error::throw_on(ec, "socket::shutdown");
+    }
+
+    void non_blocking(bool enable, std::error_code& ec) const noexcept {
+        ec.clear();
+        int ret = detail::socket_traits::non_blocking(fd, enable);
+        if(ret == -1) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    void non_blocking(bool enable = true) const {
+        std::error_code ec;
+        non_blocking(enable, ec);
+        error::throw_on(ec, "socket::non_blocking");
+    }
+
+    // lets several sockets bind the same address with the kernel spreading
+    // connections or datagrams across them. must be set before bind.
+    void reuse_port(bool enable, std::error_code& ec) const noexcept {
+    #if defined(SO_REUSEPORT)
+        set_option<int>(SOL_SOCKET, SO_REUSEPORT, enable ? 1 : 0, ec);
+    #else
+        ec.clear();
+        if(enable) {
+            ec = error::protocol_unavailable;
+        }
+    #endif // SO_REUSEPORT
+    }
+
+    void reuse_port(bool enable = true) const {
+        std::error_code ec;
+        reuse_port(enable, ec);
+        error::throw_on(ec, "socket::reuse_port");
+    }
+
+#if defined(LIBNET_LINUX)
+    // filters incoming packets on this socket
+    void attach_filter(const bpf::program& program, std::error_code& ec) const noexcept {
+        set_option(SOL_SOCKET, SO_ATTACH_FILTER, program.native(), ec);
+    }
+
+    void attach_filter(const bpf::program& program) const {
+        std::error_code ec;
+        attach_filter(program, ec);
+        error::throw_on(ec, "socket::attach_filter");
+    }
+
+    void detach_filter(std::error_code& ec) const noexcept {
+        set_option<int>(SOL_SOCKET, SO_DETACH_FILTER, 0, ec);
+    }
+
+    void detach_filter() const {
+        std::error_code ec;
+        detach_filter(ec);
+        error::throw_on(ec, "socket::detach_filter");
+    }
+
+    // picks which socket in this socket's SO_REUSEPORT group gets each packet.
+    // the program returns an index into the group in the order the sockets
+    // were bound, an out of range index falls back to the default hash.
+    void attach_reuseport(const bpf::program& program, std::error_code& ec) const noexcept {
+    #if defined(SO_ATTACH_REUSEPORT_CBPF)
+        set_option(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, program.native(), ec);
+    #else
+        (void)program;
+        ec = error::protocol_unavailable;
+    #endif // SO_ATTACH_REUSEPORT_CBPF
+    }
+
+    void attach_reuseport(const bpf::program& program) const {
+        std::error_code ec;
+        attach_reuseport(program, ec);
+        error::throw_on(ec, "socket::attach_reuseport");
+    }
+#endif // LIBNET_LINUX
+
     int type(std::error_code& ec) const noexcept {
         return get_option<int>(SOL_SOCKET, SO_TYPE, ec);
     }
@@ -119,49 +264,33 @@ public:
 
     template<typename String>
     void connect(const String& host, unsigned port, std::error_code& ec) const noexcept {
-        ec.clear();
-        auto hints = addrinfo();
-        std::unique_ptr<addrinfo, detail::addrinfo_deleter> res;
-        hints.ai_family = protocol;
-        hints.ai_socktype = type(ec);
-
+        int socket_type = type(ec);
         if(ec) {
             // at this point -- something went wrong so abort early.
             return;
         }
 
-        auto port_str = std::to_string(port);
-        auto ptr = res.get();
-        int ret = ::getaddrinfo(detail::string_traits<String>::c_str(host), port_str.c_str(), &hints, &ptr);
+        connector(detail::string_traits<String>::c_str(host), port, socket_type, ec);
+    }
 
+    template<typename String>
+    void connect(const String& host, unsigned port) const {
+        std::error_code ec;
+        connect(host, port, ec);
+        error::throw_on(ec, "socket::connect");
+    }
+
+    void connect(const endpoint& peer, std::error_code& ec) const noexcept {
+        ec.clear();
+        int ret = ::connect(fd, peer.data(), peer.size());
         if(ret != 0) {
             ec.assign(error::get_last_error(), error::socket_category());
-            return; // abort
-        }
-
-        // loop through every result in getaddrinfo and attempt to connect
-        for(addrinfo* p = ptr; p != nullptr; p = p->ai_next) {
-            int ret = ::connect(fd, p->ai_addr, p->ai_addrlen);
-
-            if(ret != 0) {
-                // check for errors
-                ec.assign(error::get_last_error(), error::socket_category());
-            }
-
-            // check if it's a recoverable error
-            if(ec == error::host_unreachable || ec == error::network_unreachable) {
-                continue;
-            }
-            else {
-                break; // it isn't, so just finish trying.
-            }
         }
     }
 
-    template<typename String>
-    void connect(const String& host, unsigned port) const {
+    void connect(const endpoint& peer) const {
         std::error_code ec;
-        connect(host, port, ec);
+        connect(peer, ec);
         error::throw_on(ec, "socket::connect");
     }
 
@@ -187,6 +316,20 @@ public:
         error::throw_on(ec, "socket::bind");
     }
 
+    void bind(const endpoint& local, std::error_code& ec) const noexcept {
+        ec.clear();
+        int ret = ::bind(fd, local.data(), local.size());
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+    void bind(const endpoint& local) const {
+        std::error_code ec;
+        bind(local, ec);
+        error::throw_on(ec, "socket::bind");
+    }
+
     void listen(int backlog, std::error_code& ec) const noexcept {
         ec.clear();
         int ret = ::listen(fd, backlog);
@@ -201,6 +344,76 @@ public:
         error::throw_on(ec, "socket::listen");
     }
 
+    // TCP Fast Open
+    // servers should call fast_open (and optionally defer_accept) before listen.
+    // queue_length is the maximum number of pending fast open requests.
+
+    void fast_open(int queue_length, std::error_code& ec) const noexcept {
+    #if defined(TCP_FASTOPEN)
+        set_option<int>(IPPROTO_TCP, TCP_FASTOPEN, queue_length, ec);
+    #else
+        (void)queue_length;
+        ec = error::protocol_unavailable;
+    #endif // TCP_FASTOPEN
+    }
+
+    void fast_open(int queue_length = 256) const {
+        std::error_code ec;
+        fast_open(queue_length, ec);
+        error::throw_on(ec, "socket::fast_open");
+    }
+
+    // only wake up accept once the client has sent data, or after the timeout
+    // in seconds has passed.
+    void defer_accept(int seconds, std::error_code& ec) const noexcept {
+    #if defined(TCP_DEFER_ACCEPT)
+        set_option<int>(IPPROTO_TCP, TCP_DEFER_ACCEPT, seconds, ec);
+    #else
+        (void)seconds;
+        ec = error::protocol_unavailable;
+    #endif // TCP_DEFER_ACCEPT
+    }
+
+    void defer_accept(int seconds = 1) const {
+        std::error_code ec;
+        defer_accept(seconds, ec);
+        error::throw_on(ec, "socket::defer_accept");
+    }
+
+    // makes a regular connect return immediately so the first send goes out with the SYN.
+    void fast_open_connect(bool enable, std::error_code& ec) const noexcept {
+    #if defined(TCP_FASTOPEN_CONNECT)
+        set_option<int>(IPPROTO_TCP, TCP_FASTOPEN_CONNECT, enable ? 1 : 0, ec);
+    #else
+        ec.clear();
+        if(enable) {
+            ec = error::protocol_unavailable;
+        }
+    #endif // TCP_FASTOPEN_CONNECT
+    }
+
+    void fast_open_connect(bool enable = true) const {
+        std::error_code ec;
+        fast_open_connect(enable, ec);
+        error::throw_on(ec, "socket::fast_open_connect");
+    }
+
+    // connects and sends the first flight of data in the SYN if possible.
+    // if fast open is unavailable it falls back to a regular connect and send.
+    // returns the number of bytes of data sent.
+    template<typename String, typename Data>
+    int fast_connect(const String& host, unsigned port, const Data& data, int flags, std::error_code& ec) const noexcept {
+        return fast_connector(detail::string_traits<String>::c_str(host), port, data, flags, 0, ec);
+    }
+
+    template<typename String, typename Data>
+    int fast_connect(const String& host, unsigned port, const Data& data, int flags = 0) const {
+        std::error_code ec;
+        int result = fast_connect(host, port, data, flags, ec);
+        error::throw_on(ec, "socket::fast_connect");
+        return result;
+    }
+
     template<typename String>
     int send(const String& str, int flags, std::error_code& ec) const noexcept {
         ec.clear();
@@ -210,6 +423,9 @@ public:
             ec.assign(error::get_last_error(), error::socket_category());
             return 0;
         }
+    #if defined(LIBNET_CAPTURE)
+        detail::tap(fd, true, trait_type::c_str(str), static_cast<size_t>(ret));
+    #endif // LIBNET_CAPTURE
         return ret;
     }
 
@@ -237,6 +453,12 @@ public:
             return {};
         }
 
+    #if defined(LIBNET_CAPTURE)
+        if(!(flags & MSG_PEEK)) {
+            detail::tap(fd, false, result.data(), static_cast<size_t>(actual_bytes));
+        }
+    #endif // LIBNET_CAPTURE
+
         if(actual_bytes < buffer_size) {
             result.resize(actual_bytes);
         }
@@ -250,18 +472,323 @@ public:
         return result;
     }
 
-    socket accept(std::error_code& ec) const noexcept {
+#if defined(LIBNET_LINUX)
+    // turns on kernel timestamping, flags is a combination of net::timestamping
+    // values or 0 to turn it off.
+    void timestamp(int flags, std::error_code& ec) const noexcept {
+        set_option<int>(SOL_SOCKET, SO_TIMESTAMPING, flags, ec);
+    }
+
+    void timestamp(int flags) const {
+        std::error_code ec;
+        timestamp(flags, ec);
+        error::throw_on(ec, "socket::timestamp");
+    }
+
+    // like receive but also reports when the kernel (or NIC) received the data.
+    // for stream sockets this is the timestamp of the last packet read.
+    std::string receive_timestamped(int buffer_size, kernel_timestamp& stamp, int flags, std::error_code& ec) const noexcept {
+        ec.clear();
+        stamp = kernel_timestamp();
+        if(buffer_size == 0) {
+            return {}; // requested nothing so just exit.
+        }
+
+        std::string result;
+        if(!error::safely_invoke([&result, &buffer_size] { result.resize(buffer_size); }, ec)) {
+            return {};
+        }
+
+        iovec iov;
+        iov.iov_base = &result[0];
+        iov.iov_len = static_cast<size_t>(buffer_size);
+        auto actual_bytes = control_receiver(&iov, flags, stamp, ec);
+        if(ec) {
+            return {};
+        }
+
+    #if defined(LIBNET_CAPTURE)
+        if(!(flags & MSG_PEEK)) {
+            detail::tap(fd, false, result.data(), static_cast<size_t>(actual_bytes));
+        }
+    #endif // LIBNET_CAPTURE
+
+        result.resize(static_cast<size_t>(actual_bytes));
+        return result;
+    }
+
+    std::string receive_timestamped(int buffer_size, kernel_timestamp& stamp, int flags = 0) const {
+        std::error_code ec;
+        auto&& result = receive_timestamped(buffer_size, stamp, flags, ec);
+        error::throw_on(ec, "socket::receive_timestamped");
+        return result;
+    }
+
+    // reads one transmit timestamp from the error queue. this never blocks,
+    // error::would_block means there is nothing queued yet.
+    kernel_timestamp receive_tx_timestamp(std::error_code& ec) const noexcept {
+        ec.clear();
+        kernel_timestamp stamp;
+        char data[1];
+        iovec iov;
+        iov.iov_base = data;
+        iov.iov_len = sizeof(data);
+        control_receiver(&iov, MSG_ERRQUEUE, stamp, ec);
+        return stamp;
+    }
+
+    kernel_timestamp receive_tx_timestamp() const {
+        std::error_code ec;
+        auto result = receive_tx_timestamp(ec);
+        error::throw_on(ec, "socket::receive_tx_timestamp");
+        return result;
+    }
+#endif // LIBNET_LINUX
+
+    template<typename String>
+    int send_to(const String& str, const endpoint& peer, int flags, std::error_code& ec) const noexcept {
+        ec.clear();
+        using trait_type = detail::string_traits<String>;
+        int ret = ::sendto(fd, trait_type::c_str(str), trait_type::size(str), flags, peer.data(), peer.size());
+        if(ret < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return 0;
+        }
+    #if defined(LIBNET_CAPTURE)
+        detail::tap(fd, true, trait_type::c_str(str), static_cast<size_t>(ret), &peer);
+    #endif // LIBNET_CAPTURE
+        return ret;
+    }
+
+    template<typename String>
+    int send_to(const String& str, const endpoint& peer, int flags = 0) const {
+        std::error_code ec;
+        int result = send_to(str, peer, flags, ec);
+        error::throw_on(ec, "socket::send_to");
+        return result;
+    }
+
+    std::string receive_from(int buffer_size, endpoint& peer, int flags, std::error_code& ec) const noexcept {
+        ec.clear();
+        if(buffer_size == 0) {
+            return {}; // requested nothing so just exit.
+        }
+
+        std::string result;
+        if(!error::safely_invoke([&result, &buffer_size] { result.resize(buffer_size); }, ec)) {
+            return {};
+        }
+
+        auto size = endpoint::capacity();
+        int actual_bytes = ::recvfrom(fd, &result[0], buffer_size, flags, peer.data(), &size);
+        if(actual_bytes < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return {};
+        }
+
+        peer.resize(size);
+    #if defined(LIBNET_CAPTURE)
+        if(!(flags & MSG_PEEK)) {
+            detail::tap(fd, false, result.data(), static_cast<size_t>(actual_bytes), &peer);
+        }
+    #endif // LIBNET_CAPTURE
+        if(actual_bytes < buffer_size) {
+            result.resize(actual_bytes);
+        }
+        return result;
+    }
+
+    std::string receive_from(int buffer_size, endpoint& peer, int flags = 0) const {
+        std::error_code ec;
+        auto&& result = receive_from(buffer_size, peer, flags, ec);
+        error::throw_on(ec, "socket::receive_from");
+        return result;
+    }
+
+    // UDP segmentation offload
+    // these are meant for datagram sockets. when the kernel supports it a large
+    // buffer is handed over in one call and split into segment_size datagrams
+    // by the stack (or the NIC), otherwise it falls back to one send per datagram.
+
+    bool segmentation_offload(std::error_code& ec) const noexcept {
+        ec.clear();
+    #if defined(UDP_SEGMENT)
+        return is_udp() && detail::udp_segmentation_supported();
+    #else
+        return false;
+    #endif // UDP_SEGMENT
+    }
+
+    bool segmentation_offload() const {
+        std::error_code ec;
+        bool result = segmentation_offload(ec);
+        error::throw_on(ec, "socket::segmentation_offload");
+        return result;
+    }
+
+    template<typename String>
+    int send_segmented(const String& str, int segment_size, int flags, std::error_code& ec) const noexcept {
         ec.clear();
-        sockaddr_storage storage;
-        socklen_t size;
+        if(segment_size <= 0) {
+            ec = error::invalid_argument;
+            return 0;
+        }
+
+        using trait_type = detail::string_traits<String>;
+        const char* data = trait_type::c_str(str);
+        size_t size = trait_type::size(str);
+        size_t segment = static_cast<size_t>(segment_size);
+        size_t offset = 0;
+
+    #if defined(UDP_SEGMENT)
+        if(size > segment && segment <= detail::max_gso_payload && detail::udp_segmentation_supported() && is_udp()) {
+            // each call can only carry so many segments
+            size_t chunk = segment * std::min(detail::max_gso_segments, detail::max_gso_payload / segment);
+            while(offset < size) {
+                size_t length = std::min(chunk, size - offset);
+                int ret = gso_sender(data + offset, length, segment_size, flags, ec);
+                if(ec) {
+                    // only fall back if nothing has been sent through the offload path yet
+                    if(offset == 0 && detail::offload_unsupported(ec)) {
+                        ec.clear();
+                        break;
+                    }
+                    return static_cast<int>(offset);
+                }
+                offset += ret;
+            }
+        }
+    #endif // UDP_SEGMENT
+
+        // one trip through the stack per datagram
+        while(offset < size) {
+            size_t length = std::min(segment, size - offset);
+            int ret = ::send(fd, data + offset, length, flags);
+            if(ret < 0) {
+                ec.assign(error::get_last_error(), error::socket_category());
+                break;
+            }
+        #if defined(LIBNET_CAPTURE)
+            detail::tap(fd, true, data + offset, static_cast<size_t>(ret));
+        #endif // LIBNET_CAPTURE
+            offset += ret;
+        }
+        return static_cast<int>(offset);
+    }
+
+    template<typename String>
+    int send_segmented(const String& str, int segment_size, int flags = 0) const {
+        std::error_code ec;
+        int result = send_segmented(str, segment_size, flags, ec);
+        error::throw_on(ec, "socket::send_segmented");
+        return result;
+    }
+
+    void coalesce(bool enable, std::error_code& ec) const noexcept {
+    #if defined(UDP_GRO)
+        set_option<int>(SOL_UDP, UDP_GRO, enable ? 1 : 0, ec);
+    #else
+        ec.clear();
+        if(enable) {
+            ec = error::protocol_unavailable;
+        }
+    #endif // UDP_GRO
+    }
+
+    void coalesce(bool enable = true) const {
+        std::error_code ec;
+        coalesce(enable, ec);
+        error::throw_on(ec, "socket::coalesce");
+    }
 
-        native_type ret = ::accept(fd, reinterpret_cast<sockaddr*>(&storage), &size);
+    // receives potentially many datagrams coalesced by the kernel (see coalesce).
+    // every datagram is segment_size bytes except the last which may be shorter.
+    // if nothing was coalesced then segment_size is the size of the lone datagram.
+    std::string receive_coalesced(int buffer_size, int& segment_size, int flags, std::error_code& ec) const noexcept {
+        segment_size = 0;
+    #if defined(UDP_GRO)
+        ec.clear();
+        if(buffer_size == 0) {
+            return {};
+        }
+
+        std::string result;
+        if(!error::safely_invoke([&result, &buffer_size] { result.resize(buffer_size); }, ec)) {
+            return {};
+        }
+
+        iovec iov;
+        iov.iov_base = &result[0];
+        iov.iov_len = static_cast<size_t>(buffer_size);
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        auto actual_bytes = ::recvmsg(fd, &msg, flags);
+        if(actual_bytes < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return {};
+        }
+
+        segment_size = static_cast<int>(actual_bytes);
+        for(cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                std::char_traits<char>::copy(reinterpret_cast<char*>(&segment_size),
+                                             reinterpret_cast<const char*>(CMSG_DATA(cmsg)), sizeof(int));
+                break;
+            }
+        }
+
+    #if defined(LIBNET_CAPTURE)
+        if(!(flags & MSG_PEEK)) {
+            detail::tap_segments(fd, false, result.data(), static_cast<size_t>(actual_bytes), static_cast<size_t>(segment_size));
+        }
+    #endif // LIBNET_CAPTURE
+
+        result.resize(static_cast<size_t>(actual_bytes));
+        return result;
+    #else
+        auto&& result = receive(buffer_size, flags, ec);
+        segment_size = static_cast<int>(result.size());
+        return result;
+    #endif // UDP_GRO
+    }
+
+    std::string receive_coalesced(int buffer_size, int& segment_size, int flags = 0) const {
+        std::error_code ec;
+        auto&& result = receive_coalesced(buffer_size, segment_size, flags, ec);
+        error::throw_on(ec, "socket::receive_coalesced");
+        return result;
+    }
+
+    socket accept(endpoint& peer, std::error_code& ec) const noexcept {
+        ec.clear();
+        auto size = endpoint::capacity();
+
+        native_type ret = ::accept(fd, peer.data(), &size);
         if(ret == socket::invalid) {
             ec.assign(error::get_last_error(), error::socket_category());
             return {};
         }
 
-        return { ret, protocol };
+        peer.resize(size);
+        return { ret, protocol, detail::adopt_t{} };
+    }
+
+    socket accept(endpoint& peer) const {
+        std::error_code ec;
+        auto&& ret = accept(peer, ec);
+        error::throw_on(ec, "socket::accept");
+        return std::move(ret);
+    }
+
+    socket accept(std::error_code& ec) const noexcept {
+        endpoint peer;
+        return accept(peer, ec);
     }
 
     socket accept() const {
@@ -270,12 +797,14 @@ public:
         error::throw_on(ec, "socket::accept");
         return std::move(ret);
     }
-private:
+protected:
+    // the rest is shared with basic_socket
+
     template<typename T>
     T get_option(int level, int flags, std::error_code& ec) const noexcept {
         ec.clear();
         T temp;
-        auto len = static_cast<int>(sizeof(T));
+        auto len = static_cast<detail::socket_traits::length_type>(sizeof(T));
         int ret = ::getsockopt(fd, level, flags, reinterpret_cast<detail::socket_traits::getopt_type>(&temp), &len);
         if(ret != 0) {
             ec.assign(error::get_last_error(), error::socket_category());
@@ -283,30 +812,207 @@ private:
         return temp;
     }
 
-    void binder(const char* str, unsigned port, std::error_code& ec) const noexcept {
+    template<typename T>
+    void set_option(int level, int flags, const T& value, std::error_code& ec) const noexcept {
+        ec.clear();
+        auto len = static_cast<detail::socket_traits::length_type>(sizeof(T));
+        int ret = ::setsockopt(fd, level, flags, reinterpret_cast<detail::socket_traits::setopt_type>(&value), len);
+        if(ret != 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+        }
+    }
+
+#if defined(LIBNET_LINUX)
+    ssize_t control_receiver(iovec* iov, int flags, kernel_timestamp& stamp, std::error_code& ec) const noexcept {
+        // room for the timestamps and an extended error with its offender address
+        alignas(cmsghdr) char control[256];
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        auto ret = ::recvmsg(fd, &msg, flags);
+        if(ret < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return 0;
+        }
+
+        detail::parse_timestamps(msg, stamp);
+        return ret;
+    }
+#endif // LIBNET_LINUX
+
+#if defined(UDP_SEGMENT)
+    // only UDP understands UDP_SEGMENT, anything else gets one send per datagram
+    bool is_udp() const noexcept {
+        std::error_code ec;
+        int proto = get_option<int>(SOL_SOCKET, SO_PROTOCOL, ec);
+        return !ec && proto == IPPROTO_UDP;
+    }
+
+    int gso_sender(const char* data, size_t size, int segment_size, int flags, std::error_code& ec) const noexcept {
+        iovec iov;
+        iov.iov_base = const_cast<char*>(data);
+        iov.iov_len = size;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        auto segment = static_cast<uint16_t>(segment_size);
+        std::char_traits<char>::copy(reinterpret_cast<char*>(CMSG_DATA(cmsg)),
+                                     reinterpret_cast<const char*>(&segment), sizeof(segment));
+
+        auto ret = ::sendmsg(fd, &msg, flags);
+        if(ret < 0) {
+            ec.assign(error::get_last_error(), error::socket_category());
+            return 0;
+        }
+    #if defined(LIBNET_CAPTURE)
+        detail::tap_segments(fd, true, data, static_cast<size_t>(ret), static_cast<size_t>(segment_size));
+    #endif // LIBNET_CAPTURE
+        return static_cast<int>(ret);
+    }
+#endif // UDP_SEGMENT
+
+    // socket_type is only needed by the fallback, 0 means look it up
+    template<typename Data>
+    int fast_connector(const char* host, unsigned port, const Data& data, int flags, int socket_type, std::error_code& ec) const noexcept {
+    #if defined(MSG_FASTOPEN)
         ec.clear();
         auto hints = addrinfo();
-        std::unique_ptr<addrinfo, detail::addrinfo_deleter> res;
+        hints.ai_family = protocol;
+        hints.ai_socktype = socket::stream;
+
+        auto port_str = std::to_string(port);
+        addrinfo* ptr = nullptr;
+        int ret = ::getaddrinfo(host, port_str.c_str(), &hints, &ptr);
+
+        if(ret != 0) {
+            ec.assign(ret, error::getaddrinfo_category());
+            return 0;
+        }
+
+        std::unique_ptr<addrinfo, detail::addrinfo_deleter> res(ptr);
+        using trait_type = detail::string_traits<Data>;
+
+        // loop through every result in getaddrinfo and attempt to connect
+        for(addrinfo* p = ptr; p != nullptr; p = p->ai_next) {
+            auto sent = ::sendto(fd, trait_type::c_str(data), trait_type::size(data), flags | MSG_FASTOPEN, p->ai_addr, p->ai_addrlen);
+
+            if(sent >= 0) {
+            #if defined(LIBNET_CAPTURE)
+                endpoint peer(p->ai_addr, static_cast<endpoint::length_type>(p->ai_addrlen));
+                detail::tap(fd, true, trait_type::c_str(data), static_cast<size_t>(sent), &peer);
+            #endif // LIBNET_CAPTURE
+                return static_cast<int>(sent);
+            }
+
+            ec.assign(error::get_last_error(), error::socket_category());
+
+            // fast open is disabled on this host so do it the long way
+            if(ec == error::operation_not_supported) {
+                break;
+            }
+
+            // check if it's a recoverable error
+            if(ec == error::host_unreachable || ec == error::network_unreachable) {
+                continue;
+            }
+            return 0;
+        }
+
+        if(ec != error::operation_not_supported) {
+            return 0;
+        }
+    #endif // MSG_FASTOPEN
 
+        if(socket_type == 0) {
+            socket_type = type(ec);
+            if(ec) {
+                return 0;
+            }
+        }
+
+        connector(host, port, socket_type, ec);
+        if(ec) {
+            return 0;
+        }
+        return send(data, flags, ec);
+    }
+
+    void connector(const char* host, unsigned port, int socket_type, std::error_code& ec) const noexcept {
+        ec.clear();
+        auto hints = addrinfo();
         hints.ai_family = protocol;
-        hints.ai_socktype = type(ec);
+        hints.ai_socktype = socket_type;
+
+        auto port_str = std::to_string(port);
+        addrinfo* ptr = nullptr;
+        int ret = ::getaddrinfo(host, port_str.c_str(), &hints, &ptr);
+
+        if(ret != 0) {
+            ec.assign(ret, error::getaddrinfo_category());
+            return; // abort
+        }
+
+        std::unique_ptr<addrinfo, detail::addrinfo_deleter> res(ptr);
+
+        // loop through every result in getaddrinfo and attempt to connect
+        for(addrinfo* p = ptr; p != nullptr; p = p->ai_next) {
+            int ret = ::connect(fd, p->ai_addr, p->ai_addrlen);
+
+            if(ret == 0) {
+                ec.clear();
+                break;
+            }
+
+            ec.assign(error::get_last_error(), error::socket_category());
+
+            // check if it's a recoverable error
+            if(ec != error::host_unreachable && ec != error::network_unreachable) {
+                break; // it isn't, so just finish trying.
+            }
+        }
+    }
+
+    void binder(const char* str, unsigned port, std::error_code& ec) const noexcept {
+        int socket_type = type(ec);
         if(ec) {
             return; // abort
         }
 
+        binder(str, port, socket_type, ec);
+    }
+
+    void binder(const char* str, unsigned port, int socket_type, std::error_code& ec) const noexcept {
+        ec.clear();
+        auto hints = addrinfo();
+        hints.ai_family = protocol;
+        hints.ai_socktype = socket_type;
+
         if(str == nullptr) {
             hints.ai_flags = AI_PASSIVE;
         }
 
         auto port_str = std::to_string(port);
-        auto ptr = res.get();
+        addrinfo* ptr = nullptr;
         int ret = ::getaddrinfo(str, port_str.c_str(), &hints, &ptr);
 
         if(ret != 0) {
-            ec.assign(error::get_last_error(), error::socket_category());
+            ec.assign(ret, error::getaddrinfo_category());
             return; // can't bind yet
         }
 
+        std::unique_ptr<addrinfo, detail::addrinfo_deleter> res(ptr);
         int error = ::bind(fd, ptr->ai_addr, ptr->ai_addrlen);
 
         if(error != 0) {
@@ -314,7 +1020,7 @@ private:
         }
     }
 
-    socket(native_type new_fd, int new_protocol): fd(new_fd), protocol(new_protocol) {}
+    socket(native_type new_fd, int new_protocol, detail::adopt_t): fd(new_fd), protocol(new_protocol) {}
 
     native_type fd;
     int protocol;
@@ -0,0 +1,111 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef LIBNET_TIMESTAMP_HPP
+#define LIBNET_TIMESTAMP_HPP
+
+// Kernel timestamps for sent and received packets through SO_TIMESTAMPING.
+// See socket::timestamp, socket::receive_timestamped and
+// socket::receive_tx_timestamp. Linux only.
+
+#include <net/detail/config.hpp>
+
+#if defined(LIBNET_LINUX)
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+
+namespace net {
+namespace timestamping {
+enum : int {
+    // when packets are received, taken by the stack or the NIC
+    rx_software = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE,
+    rx_hardware = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE,
+
+    // when packets leave, reported through the error queue with an id per send.
+    // hardware timestamps also need the interface configured with SIOCSHWTSTAMP.
+    tx_software = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY,
+    tx_hardware = SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY,
+
+    // additional points along the transmit path
+    tx_scheduled    = SOF_TIMESTAMPING_TX_SCHED | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY,
+    tx_acknowledged = SOF_TIMESTAMPING_TX_ACK | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY
+};
+} // timestamping
+
+// which point on the transmit path a tx timestamp was taken at
+enum class tx_point : int {
+    none      = -1,
+    sent      = SCM_TSTAMP_SND,
+    scheduled = SCM_TSTAMP_SCHED,
+    acked     = SCM_TSTAMP_ACK
+};
+
+// nanoseconds since the epoch of CLOCK_REALTIME, or of the NIC's clock for
+// hardware timestamps. zero means the timestamp wasn't provided.
+struct kernel_timestamp {
+    std::chrono::nanoseconds software{0};
+    std::chrono::nanoseconds hardware{0};
+
+    // for tx timestamps, the number of the send this belongs to counting
+    // bytes for stream sockets and datagrams otherwise, starting at zero.
+    uint32_t id = 0;
+    tx_point point = tx_point::none;
+};
+
+namespace detail {
+inline std::chrono::nanoseconds to_duration(const timespec& ts) noexcept {
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// fills in the timestamp from the control messages, returns true if one was found.
+inline bool parse_timestamps(msghdr& msg, kernel_timestamp& result) noexcept {
+    bool found = false;
+    for(cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            result.software = to_duration(stamps.ts[0]);
+            result.hardware = to_duration(stamps.ts[2]);
+            found = true;
+        }
+        else if((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if(err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                result.id = err.ee_data;
+                result.point = static_cast<tx_point>(err.ee_info);
+            }
+        }
+    }
+    return found;
+}
+} // detail
+} // net
+
+#endif // LIBNET_LINUX
+#endif // LIBNET_TIMESTAMP_HPP
@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Loopback check that TCP Fast Open carries data in the SYN.
+//
+// A first connection fetches a fast open cookie, the second one uses it
+// so its data should arrive with the SYN. The listener uses defer_accept
+// so accept only returns once data is there. Linux only, and needs the
+// client and server bits of net.ipv4.tcp_fastopen set (e.g. sysctl -w net.ipv4.tcp_fastopen=3).
+//
+// Building:
+//     c++ -std=c++11 -O2 -I. tools/fast_open_test.cpp -o fast_open_test
+//
+// Exits with 0 on success, 1 on failure and 77 if fast open is disabled.
+
+#include <net/socket.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <netinet/tcp.h>
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    std::cout << (condition ? "ok:   " : "FAIL: ") << what << '\n';
+    if(!condition) {
+        ++failures;
+    }
+}
+
+int sysctl_fast_open() {
+    std::ifstream in("/proc/sys/net/ipv4/tcp_fastopen");
+    int value = 0;
+    in >> value;
+    return value;
+}
+
+// TcpExt counters come as a line of names followed by a line of values
+long long netstat_counter(const std::string& name) {
+    std::ifstream in("/proc/net/netstat");
+    std::string names;
+    std::string values;
+    while(std::getline(in, names) && std::getline(in, values)) {
+        if(names.compare(0, 7, "TcpExt:") != 0) {
+            continue;
+        }
+
+        std::istringstream n(names);
+        std::istringstream v(values);
+        std::string key;
+        std::string value;
+        while(n >> key && v >> value) {
+            if(key == name) {
+                return std::atoll(value.c_str());
+            }
+        }
+    }
+    return -1;
+}
+
+bool sent_syn_data(const net::socket& client) {
+    tcp_info info = {};
+    socklen_t size = sizeof(info);
+    if(::getsockopt(client.native_handle(), IPPROTO_TCP, TCP_INFO, &info, &size) != 0) {
+        return false;
+    }
+    return (info.tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+}
+
+net::endpoint local_endpoint(const net::socket& s) {
+    net::endpoint result;
+    auto size = net::endpoint::capacity();
+    if(::getsockname(s.native_handle(), result.data(), &size) == 0) {
+        result.resize(size);
+    }
+    return result;
+}
+} // anonymous namespace
+
+int main() {
+    if((sysctl_fast_open() & 3) != 3) {
+        std::cout << "skipped: client and server side fast open need to be enabled (net.ipv4.tcp_fastopen)\n";
+        return 77;
+    }
+
+    net::socket listener(net::socket::ipv4);
+    listener.bind(net::endpoint("127.0.0.1", 0));
+    listener.fast_open();
+    listener.defer_accept();
+    listener.listen();
+    auto address = local_endpoint(listener);
+    std::string payload = "hello with the SYN";
+
+    // the first connection only gets a cookie
+    {
+        net::socket client(net::socket::ipv4);
+        client.fast_connect(address.address(), address.port(), payload);
+        auto server = listener.accept();
+        check(server.receive(64) == payload, "priming connection delivers its data");
+    }
+
+    auto passive_before = netstat_counter("TCPFastOpenPassive");
+
+    net::socket client(net::socket::ipv4);
+    int sent = client.fast_connect(address.address(), address.port(), payload);
+    check(sent == static_cast<int>(payload.size()), "fast_connect reports the whole payload as sent");
+
+    auto server = listener.accept();
+    std::error_code ec;
+    auto received = server.receive(64, MSG_DONTWAIT, ec);
+    check(!ec && received == payload, "data is readable right after accept");
+    check(sent_syn_data(client), "TCP_INFO reports data in the SYN");
+
+    auto passive_after = netstat_counter("TCPFastOpenPassive");
+    check(passive_before >= 0 && passive_after > passive_before, "TCPFastOpenPassive went up");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,750 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// A wrk style load generator built on net::socket.
+//
+// It sends requests at a constant rate no matter how fast responses come
+// back (open loop) and measures latency from when each request was meant
+// to be sent, so a stalled server can't hide its stalls by slowing the
+// generator down (coordinated omission). Linux only since it uses epoll.
+//
+// Building:
+//     c++ -std=c++11 -O2 -pthread -I. tools/loadgen.cpp -o loadgen
+//
+// Usage:
+//     loadgen [options] tcp://host:port | udp://host:port | unix:///path
+//     loadgen --serve <url>    runs the bundled echo server
+//     loadgen --self [options] <url>    runs the echo server in process too
+
+#include <net/socket.hpp>
+#include <net/histogram.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/un.h>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+struct target {
+    std::string url;
+    int family = AF_UNSPEC;
+    int type = SOCK_STREAM;
+    net::endpoint address;
+};
+
+struct options {
+    target where;
+    size_t connections = 100;
+    size_t threads = 1;
+    double rate = 1000.0;
+    double duration = 10.0;
+    std::string request = "ping\n";
+    size_t response_bytes = 0; // 0 means the same size as the request, i.e. an echo
+    bool serve = false;
+    bool self = false;
+};
+
+struct results {
+    net::histogram corrected;   // from the intended send time
+    net::histogram service;     // from the actual send time
+    uint64_t sent = 0;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    uint64_t outstanding = 0;
+};
+
+[[noreturn]] void usage(const char* error = nullptr) {
+    if(error != nullptr) {
+        std::cerr << "error: " << error << "\n\n";
+    }
+
+    std::cerr << "usage: loadgen [options] <url>\n"
+                 "\n"
+                 "urls are tcp://host:port, udp://host:port or unix:///path\n"
+                 "\n"
+                 "options:\n"
+                 "  -c, --connections N     concurrent connections (default 100)\n"
+                 "  -t, --threads N         worker threads (default 1)\n"
+                 "  -r, --rate N            total requests per second (default 1000)\n"
+                 "  -d, --duration S        seconds to run for (default 10)\n"
+                 "  --request TEXT          request template, \\r \\n \\t and \\\\ are unescaped\n"
+                 "  --request-file PATH     read the request template from a file\n"
+                 "  --response-bytes N      bytes in a response (default: size of the request)\n"
+                 "  --serve                 run the bundled echo server on <url>\n"
+                 "  --self                  also run the echo server in process\n"
+                 "\n"
+                 "the template may contain {conn} and {seq} which are replaced by the\n"
+                 "connection number and the request number on that connection.\n";
+    std::exit(error != nullptr ? 2 : 0);
+}
+
+std::string unescape(const std::string& text) {
+    std::string result;
+    for(size_t i = 0; i < text.size(); ++i) {
+        if(text[i] != '\\' || i + 1 == text.size()) {
+            result += text[i];
+            continue;
+        }
+
+        switch(text[++i]) {
+        case 'r':
+            result += '\r';
+            break;
+        case 'n':
+            result += '\n';
+            break;
+        case 't':
+            result += '\t';
+            break;
+        default:
+            result += text[i];
+            break;
+        }
+    }
+    return result;
+}
+
+bool parse_target(const std::string& url, target& out) {
+    out.url = url;
+    auto scheme_end = url.find("://");
+    if(scheme_end == std::string::npos) {
+        return false;
+    }
+
+    auto scheme = url.substr(0, scheme_end);
+    auto rest = url.substr(scheme_end + 3);
+
+    if(scheme == "unix") {
+        sockaddr_un address = sockaddr_un();
+        address.sun_family = AF_UNIX;
+        if(rest.empty() || rest.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+
+        std::memcpy(address.sun_path, rest.data(), rest.size());
+        out.family = AF_UNIX;
+        out.type = SOCK_STREAM;
+        out.address = net::endpoint(reinterpret_cast<const sockaddr*>(&address),
+                                    static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + rest.size() + 1));
+        return true;
+    }
+
+    if(scheme == "tcp") {
+        out.type = SOCK_STREAM;
+    }
+    else if(scheme == "udp") {
+        out.type = SOCK_DGRAM;
+    }
+    else {
+        return false;
+    }
+
+    // host:port or [v6]:port
+    auto colon = rest.rfind(':');
+    if(colon == std::string::npos) {
+        return false;
+    }
+
+    auto host = rest.substr(0, colon);
+    if(host.size() > 1 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+
+    char* end = nullptr;
+    unsigned long port = std::strtoul(rest.c_str() + colon + 1, &end, 10);
+    if(*end != '\0' || port > 65535) {
+        return false;
+    }
+
+    std::error_code ec;
+    out.address = net::resolve(host, static_cast<unsigned>(port), AF_UNSPEC, out.type, ec);
+    if(ec) {
+        std::cerr << "error: could not resolve " << host << ": " << ec.message() << '\n';
+        return false;
+    }
+
+    out.family = out.address.family();
+    return true;
+}
+
+options parse_options(int argc, char** argv) {
+    options result;
+    std::string url;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if(i + 1 >= argc) {
+                usage(("missing value for " + arg).c_str());
+            }
+            return argv[++i];
+        };
+
+        if(arg == "-h" || arg == "--help") {
+            usage();
+        }
+        else if(arg == "-c" || arg == "--connections") {
+            result.connections = std::strtoul(value().c_str(), nullptr, 10);
+        }
+        else if(arg == "-t" || arg == "--threads") {
+            result.threads = std::strtoul(value().c_str(), nullptr, 10);
+        }
+        else if(arg == "-r" || arg == "--rate") {
+            result.rate = std::strtod(value().c_str(), nullptr);
+        }
+        else if(arg == "-d" || arg == "--duration") {
+            result.duration = std::strtod(value().c_str(), nullptr);
+        }
+        else if(arg == "--request") {
+            result.request = unescape(value());
+        }
+        else if(arg == "--request-file") {
+            std::ifstream in(value(), std::ios::binary);
+            if(!in) {
+                usage("could not open the request file");
+            }
+            std::ostringstream contents;
+            contents << in.rdbuf();
+            result.request = contents.str();
+        }
+        else if(arg == "--response-bytes") {
+            result.response_bytes = std::strtoul(value().c_str(), nullptr, 10);
+        }
+        else if(arg == "--serve") {
+            result.serve = true;
+        }
+        else if(arg == "--self") {
+            result.self = true;
+        }
+        else if(!arg.empty() && arg[0] == '-') {
+            usage(("unknown option " + arg).c_str());
+        }
+        else {
+            url = arg;
+        }
+    }
+
+    if(url.empty()) {
+        usage("no url given");
+    }
+
+    if(!parse_target(url, result.where)) {
+        usage(("invalid url " + url).c_str());
+    }
+
+    if(result.connections == 0 || result.threads == 0 || result.rate <= 0 || result.duration <= 0) {
+        usage("connections, threads, rate and duration must be positive");
+    }
+
+    result.threads = std::min(result.threads, result.connections);
+    if(result.request.empty()) {
+        usage("the request can't be empty");
+    }
+    return result;
+}
+
+// substitutes {conn} and {seq} in the template
+struct request_template {
+    std::vector<std::string> pieces;
+    std::vector<int> holes; // 0 = conn, 1 = seq, placed between pieces
+    bool constant = true;
+
+    explicit request_template(const std::string& text) {
+        std::string current;
+        for(size_t i = 0; i < text.size();) {
+            if(text.compare(i, 6, "{conn}") == 0) {
+                pieces.push_back(current);
+                holes.push_back(0);
+                current.clear();
+                i += 6;
+            }
+            else if(text.compare(i, 5, "{seq}") == 0) {
+                pieces.push_back(current);
+                holes.push_back(1);
+                current.clear();
+                i += 5;
+            }
+            else {
+                current += text[i++];
+            }
+        }
+        pieces.push_back(current);
+        constant = holes.empty();
+    }
+
+    std::string render(size_t conn, uint64_t seq) const {
+        std::string result = pieces[0];
+        for(size_t i = 0; i < holes.size(); ++i) {
+            result += std::to_string(holes[i] == 0 ? static_cast<uint64_t>(conn) : seq);
+            result += pieces[i + 1];
+        }
+        return result;
+    }
+};
+
+bool would_block(const std::error_code& ec) {
+    return ec == net::error::would_block || ec == net::error::try_again || ec == net::error::interrupted;
+}
+
+void watch(int epoll, int op, int fd, uint32_t events, uint64_t tag) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.u64 = tag;
+    ::epoll_ctl(epoll, op, fd, &event);
+}
+
+// read interest never changes, so only flip EPOLLOUT when there's
+// something new to wait for instead of calling epoll_ctl every time
+void want_write(int epoll, int fd, bool& writing, bool enable, uint64_t tag) {
+    if(writing != enable) {
+        writing = enable;
+        watch(epoll, EPOLL_CTL_MOD, fd, EPOLLIN | (enable ? static_cast<uint32_t>(EPOLLOUT) : 0u), tag);
+    }
+}
+
+// bundled echo server
+
+void serve(const target& where, const std::atomic<bool>& stop) {
+    net::socket listener(where.family, where.type);
+    if(where.family != AF_UNIX) {
+        listener.reuse_port();
+    }
+    else {
+        ::unlink(where.address.address().c_str());
+    }
+
+    listener.bind(where.address);
+    listener.non_blocking();
+
+    int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    watch(epoll, EPOLL_CTL_ADD, listener.native_handle(), EPOLLIN, static_cast<uint64_t>(listener.native_handle()));
+
+    struct client {
+        net::socket sock;
+        std::string pending;
+        bool writing = false;
+    };
+
+    std::map<int, client> clients;
+    std::error_code ec;
+    if(where.type == SOCK_STREAM) {
+        listener.listen(4096);
+    }
+
+    epoll_event events[256];
+    while(!stop.load(std::memory_order_relaxed)) {
+        int count = ::epoll_wait(epoll, events, 256, 100);
+        for(int i = 0; i < count; ++i) {
+            int fd = static_cast<int>(events[i].data.u64);
+
+            if(fd == listener.native_handle() && where.type == SOCK_DGRAM) {
+                net::endpoint peer;
+                while(true) {
+                    auto datagram = listener.receive_from(65536, peer, 0, ec);
+                    if(ec) {
+                        break;
+                    }
+                    listener.send_to(datagram, peer, 0, ec);
+                }
+                continue;
+            }
+
+            if(fd == listener.native_handle()) {
+                while(true) {
+                    auto accepted = listener.accept(ec);
+                    if(ec) {
+                        break;
+                    }
+                    accepted.non_blocking();
+                    int handle = accepted.native_handle();
+                    clients[handle].sock = std::move(accepted);
+                    watch(epoll, EPOLL_CTL_ADD, handle, EPOLLIN, static_cast<uint64_t>(handle));
+                }
+                continue;
+            }
+
+            auto it = clients.find(fd);
+            if(it == clients.end()) {
+                continue;
+            }
+
+            auto& c = it->second;
+            bool closed = (events[i].events & (EPOLLHUP | EPOLLERR)) != 0;
+            while(!closed) {
+                auto data = c.sock.receive(65536, 0, ec);
+                if(ec) {
+                    closed = !would_block(ec);
+                    break;
+                }
+                if(data.empty()) {
+                    closed = true;
+                    break;
+                }
+                c.pending += data;
+            }
+
+            while(!c.pending.empty() && !closed) {
+                int sent = c.sock.send(c.pending, MSG_NOSIGNAL, ec);
+                if(ec) {
+                    closed = !would_block(ec);
+                    break;
+                }
+                c.pending.erase(0, static_cast<size_t>(sent));
+            }
+
+            if(closed) {
+                ::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+                clients.erase(it);
+                continue;
+            }
+
+            want_write(epoll, fd, c.writing, !c.pending.empty(), static_cast<uint64_t>(fd));
+        }
+    }
+
+    ::close(epoll);
+    if(where.family == AF_UNIX) {
+        ::unlink(where.address.address().c_str());
+    }
+}
+
+// load generation
+
+struct in_flight {
+    clock_type::time_point intended;
+    clock_type::time_point sent;  // when the last byte left the outbox
+    size_t bytes;
+    size_t unsent;                // request bytes still in the outbox
+};
+
+struct connection {
+    net::socket sock;
+    std::deque<in_flight> waiting;
+    std::string outbox;
+    size_t received = 0; // bytes of the oldest response seen so far
+    size_t queued = 0;   // requests at the back of waiting not fully written yet
+    uint64_t sequence = 0;
+    bool writing = false; // EPOLLOUT is registered
+    bool broken = false;
+};
+
+void generate(const options& opts, size_t first, size_t count, clock_type::time_point start, results& out) {
+    const request_template format(opts.request);
+    const std::string fixed = format.render(0, 0);
+    const bool stream = opts.where.type == SOCK_STREAM;
+    const auto end = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(opts.duration));
+
+    // every connection sends at rate / connections, staggered so the total is smooth
+    const auto interval = std::chrono::duration<double>(static_cast<double>(opts.connections) / opts.rate);
+    const auto step = std::chrono::duration_cast<clock_type::duration>(interval);
+
+    int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<connection> conns(count);
+    std::error_code ec;
+
+    for(size_t i = 0; i < count; ++i) {
+        auto& c = conns[i];
+        c.sock = net::socket(opts.where.family, opts.where.type);
+        c.sock.connect(opts.where.address, ec);
+        if(ec) {
+            if(out.errors == 0) {
+                std::cerr << "error: connect to " << opts.where.url << " failed: " << ec.message() << '\n';
+            }
+            c.broken = true;
+            ++out.errors;
+            continue;
+        }
+        c.sock.non_blocking();
+        watch(epoll, EPOLL_CTL_ADD, c.sock.native_handle(), EPOLLIN, i);
+    }
+
+    // broken connections stay scheduled so every request they miss counts as an error
+    using slot = std::pair<clock_type::time_point, size_t>;
+    std::priority_queue<slot, std::vector<slot>, std::greater<slot>> schedule;
+    for(size_t i = 0; i < count; ++i) {
+        auto offset = std::chrono::duration_cast<clock_type::duration>(interval * (static_cast<double>(first + i) / static_cast<double>(opts.connections)));
+        schedule.emplace(start + offset, i);
+    }
+
+    auto response_size = [&](size_t request) {
+        return opts.response_bytes != 0 ? opts.response_bytes : request;
+    };
+
+    auto complete = [&](connection& c, clock_type::time_point now) {
+        auto done = c.waiting.front();
+        c.waiting.pop_front();
+        c.queued = std::min(c.queued, c.waiting.size());
+        out.corrected.record(now - done.intended);
+        out.service.record(now - done.sent);
+        ++out.completed;
+    };
+
+    // a dead connection has to leave epoll, otherwise its hangup keeps waking us up
+    auto fail = [&](connection& c, const char* why) {
+        if(out.errors == 0) {
+            std::cerr << "error: connection to " << opts.where.url << ' ' << why << '\n';
+        }
+        ++out.errors;
+        c.broken = true;
+        ::epoll_ctl(epoll, EPOLL_CTL_DEL, c.sock.native_handle(), nullptr);
+        std::error_code ignored;
+        c.sock.close(ignored);
+    };
+
+    // stamps requests with the time their last byte was handed to the kernel
+    auto written = [&](connection& c, size_t bytes, clock_type::time_point now) {
+        while(bytes > 0 && c.queued > 0) {
+            auto& request = c.waiting[c.waiting.size() - c.queued];
+            size_t count = std::min(bytes, request.unsent);
+            request.unsent -= count;
+            bytes -= count;
+            if(request.unsent == 0) {
+                request.sent = now;
+                --c.queued;
+            }
+        }
+    };
+
+    auto flush = [&](connection& c, size_t index, clock_type::time_point now) {
+        while(!c.outbox.empty()) {
+            int sent = c.sock.send(c.outbox, MSG_NOSIGNAL, ec);
+            if(ec) {
+                if(!would_block(ec)) {
+                    fail(c, "failed to send");
+                    return;
+                }
+                break;
+            }
+            c.outbox.erase(0, static_cast<size_t>(sent));
+            written(c, static_cast<size_t>(sent), now);
+        }
+        want_write(epoll, c.sock.native_handle(), c.writing, !c.outbox.empty(), index);
+    };
+
+    auto drain = [&](connection& c, clock_type::time_point now) {
+        while(!c.broken) {
+            auto data = c.sock.receive(65536, 0, ec);
+            if(ec) {
+                if(!would_block(ec)) {
+                    fail(c, "failed to receive");
+                }
+                return;
+            }
+
+            if(data.empty()) {
+                fail(c, "was closed by the server");
+                return;
+            }
+
+            if(!stream) {
+                // one datagram answers one request
+                if(!c.waiting.empty()) {
+                    complete(c, now);
+                }
+                continue;
+            }
+
+            c.received += data.size();
+            while(!c.waiting.empty() && c.received >= c.waiting.front().bytes) {
+                c.received -= c.waiting.front().bytes;
+                complete(c, now);
+            }
+        }
+    };
+
+    epoll_event events[512];
+    auto now = clock_type::now();
+    auto deadline = end + std::chrono::seconds(1); // grace period for stragglers
+
+    while(now < deadline) {
+        while(!schedule.empty() && schedule.top().first <= now && schedule.top().first < end) {
+            auto next = schedule.top();
+            schedule.pop();
+            auto& c = conns[next.second];
+            schedule.emplace(next.first + step, next.second);
+            if(c.broken) {
+                ++out.errors;
+                continue;
+            }
+
+            auto payload = format.constant ? fixed : format.render(first + next.second, c.sequence);
+            ++c.sequence;
+            ++out.sent;
+            c.waiting.push_back({ next.first, now, response_size(payload.size()), stream ? payload.size() : 0 });
+            if(stream) {
+                c.outbox += payload;
+                ++c.queued;
+                flush(c, next.second, now);
+            }
+            else {
+                c.sock.send(payload, 0, ec);
+                if(ec && !would_block(ec)) {
+                    ++out.errors;
+                }
+            }
+        }
+
+        if(now >= end) {
+            bool idle = true;
+            for(auto& c : conns) {
+                if(!c.broken && !c.waiting.empty()) {
+                    idle = false;
+                    break;
+                }
+            }
+            if(idle) {
+                break;
+            }
+        }
+
+        int timeout = 1;
+        if(!schedule.empty() && schedule.top().first < end) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(schedule.top().first - now).count();
+            timeout = static_cast<int>(std::max<long long>(0, std::min<long long>(wait, 100)));
+        }
+
+        int ready = ::epoll_wait(epoll, events, 512, timeout);
+        now = clock_type::now();
+        for(int i = 0; i < ready; ++i) {
+            auto index = static_cast<size_t>(events[i].data.u64);
+            auto& c = conns[index];
+            if(!c.broken && (events[i].events & EPOLLOUT)) {
+                flush(c, index, now);
+            }
+            if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                drain(c, now);
+            }
+        }
+    }
+
+    for(auto& c : conns) {
+        out.outstanding += c.waiting.size();
+    }
+    ::close(epoll);
+}
+
+std::string format_ns(double ns) {
+    char buffer[32];
+    if(ns >= 1e9) {
+        std::snprintf(buffer, sizeof(buffer), "%.2fs", ns / 1e9);
+    }
+    else if(ns >= 1e6) {
+        std::snprintf(buffer, sizeof(buffer), "%.2fms", ns / 1e6);
+    }
+    else {
+        std::snprintf(buffer, sizeof(buffer), "%.2fus", ns / 1e3);
+    }
+    return buffer;
+}
+
+void report(const char* title, const net::histogram& h) {
+    std::cout << "  " << title << '\n'
+              << "    mean     " << format_ns(h.mean()) << '\n';
+    const double points[] = { 50.0, 75.0, 90.0, 99.0, 99.9, 99.99 };
+    for(double p : points) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "p%-7g", p);
+        std::cout << "    " << label << ' ' << format_ns(static_cast<double>(h.percentile(p))) << '\n';
+    }
+    std::cout << "    max      " << format_ns(static_cast<double>(h.max())) << '\n';
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    auto opts = parse_options(argc, argv);
+    std::atomic<bool> stop{false};
+
+    if(opts.serve) {
+        std::cout << "echo server listening on " << opts.where.url << std::endl;
+        serve(opts.where, stop);
+        return 0;
+    }
+
+    std::thread server;
+    if(opts.self) {
+        server = std::thread([&opts, &stop] { serve(opts.where, stop); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::cout << "running " << opts.duration << "s test @ " << opts.where.url << '\n'
+              << "  " << opts.threads << " threads and " << opts.connections << " connections, "
+              << opts.rate << " requests/sec\n";
+
+    std::vector<results> per_thread(opts.threads);
+    std::vector<std::thread> workers;
+    auto start = clock_type::now() + std::chrono::milliseconds(100);
+    size_t first = 0;
+    for(size_t t = 0; t < opts.threads; ++t) {
+        size_t count = opts.connections / opts.threads + (t < opts.connections % opts.threads ? 1 : 0);
+        workers.emplace_back([&opts, &per_thread, first, count, start, t] {
+            try {
+                generate(opts, first, count, start, per_thread[t]);
+            }
+            catch(const std::exception& e) {
+                std::cerr << "error: " << e.what() << '\n';
+                ++per_thread[t].errors;
+            }
+        });
+        first += count;
+    }
+
+    for(auto& w : workers) {
+        w.join();
+    }
+
+    stop = true;
+    if(server.joinable()) {
+        server.join();
+    }
+
+    results total;
+    for(auto& r : per_thread) {
+        total.corrected.merge(r.corrected);
+        total.service.merge(r.service);
+        total.sent += r.sent;
+        total.completed += r.completed;
+        total.errors += r.errors;
+        total.outstanding += r.outstanding;
+    }
+
+    report("latency (corrected for coordinated omission)", total.corrected);
+    report("service time (from actual send)", total.service);
+    std::cout << "  " << total.sent << " requests sent, " << total.completed << " completed, "
+              << total.outstanding << " unanswered, " << total.errors << " errors\n"
+              << "requests/sec: " << static_cast<double>(total.completed) / opts.duration << '\n';
+    return total.errors != 0 ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2015 Danny "Rapptz" Y.
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+// Compares net::relay against a plain receive/send copy loop.
+//
+// A source thread pushes the given number of bytes over loopback into the
+// middle, which forwards them to a sink thread either with relay (splice
+// through a pipe) or by receiving into user space and sending it back out.
+// Both rates are printed so the difference on this machine is visible. Linux only.
+//
+// Building:
+//     c++ -std=c++11 -O2 -pthread -I. tools/relay_bench.cpp -o relay_bench
+//
+// Usage:
+//     relay_bench [megabytes (default 1024)] [chunk bytes (default 65536)]
+
+#include <net/relay.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+net::endpoint local_endpoint(const net::socket& s) {
+    net::endpoint result;
+    auto size = net::endpoint::capacity();
+    if(::getsockname(s.native_handle(), result.data(), &size) == 0) {
+        result.resize(size);
+    }
+    return result;
+}
+
+void send_all(const net::socket& s, const std::string& data) {
+    size_t offset = 0;
+    while(offset < data.size()) {
+        offset += static_cast<size_t>(s.send(offset == 0 ? data : data.substr(offset)));
+    }
+}
+
+struct pipeline {
+    net::socket listener{net::socket::ipv4};
+    net::socket middle_in;   // accepted from the source
+    net::socket middle_out{net::socket::ipv4};  // connected to the sink
+    net::socket sink;
+};
+
+// source -> middle_in ... middle_out -> sink
+// returns the rate in bytes per second the middle moved the data at
+template<typename Forward>
+double measure(uint64_t total, int chunk, Forward&& forward, bool& ok) {
+    pipeline p;
+    p.listener.bind(net::endpoint("127.0.0.1", 0));
+    p.listener.listen();
+    auto address = local_endpoint(p.listener);
+
+    std::thread source([&] {
+        net::socket s(net::socket::ipv4);
+        s.connect(address);
+        std::string block(static_cast<size_t>(chunk), 'x');
+        uint64_t sent = 0;
+        while(sent < total) {
+            auto n = std::min<uint64_t>(block.size(), total - sent);
+            send_all(s, n == block.size() ? block : block.substr(0, static_cast<size_t>(n)));
+            sent += n;
+        }
+        s.shutdown(net::direction::send);
+        // wait for the middle to finish so nothing is reset under it
+        s.receive(1);
+    });
+
+    p.middle_in = p.listener.accept();
+    p.middle_out.connect(address);
+    p.sink = p.listener.accept();
+
+    uint64_t received = 0;
+    std::thread sink([&] {
+        while(true) {
+            auto data = p.sink.receive(chunk);
+            if(data.empty()) {
+                break;
+            }
+            received += data.size();
+        }
+        // lets the relay see end of file in the return direction
+        p.sink.shutdown(net::direction::send);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    forward(p);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sink.join();
+    std::error_code ec;
+    p.middle_in.shutdown(net::direction::send, ec);  // already done by relay, not by the copy loop
+    source.join();
+
+    if(received != total) {
+        std::cerr << "error: sink received " << received << " of " << total << " bytes\n";
+        ok = false;
+    }
+    return static_cast<double>(total) / elapsed;
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    uint64_t megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    int chunk = argc > 2 ? std::atoi(argv[2]) : 65536;
+    if(megabytes == 0 || chunk <= 0) {
+        std::cerr << "usage: relay_bench [megabytes] [chunk bytes]\n";
+        return 2;
+    }
+
+    uint64_t total = megabytes << 20;
+    bool ok = true;
+
+    double copied = measure(total, chunk, [&](pipeline& p) {
+        while(true) {
+            auto data = p.middle_in.receive(chunk);
+            if(data.empty()) {
+                break;
+            }
+            send_all(p.middle_out, data);
+        }
+        p.middle_out.shutdown(net::direction::send);
+    }, ok);
+
+    double spliced = measure(total, chunk, [&](pipeline& p) {
+        net::relay r(p.middle_in, p.middle_out);
+        r.run();
+        if(r.forwarded() != total) {
+            std::cerr << "error: relay forwarded " << r.forwarded() << " of " << total << " bytes\n";
+            ok = false;
+        }
+    }, ok);
+
+    std::cout << "bytes:         " << total << '\n'
+              << "receive/send:  " << copied / 1e6 << " MB/s\n"
+              << "relay:         " << spliced / 1e6 << " MB/s (" << spliced / copied << "x)\n";
+    return ok ? 0 : 1;
+}